@@ -10,6 +10,7 @@
 #include "scene/gui/button.h"
 #include "scene/gui/box_container.h"
 #include "scene/gui/check_box.h"
+#include "scene/gui/progress_bar.h"
 
 #ifdef TR_LIB_EXTERNAL_PLUGIN
 
@@ -20,15 +21,65 @@ protected:
 	HBoxContainer *container = nullptr;
 
 	TRLevel *level_node = nullptr;
+	ObjectID loading_level_id;
 	Button *reload_level_button = nullptr;
+	Button *cancel_load_button = nullptr;
 	CheckBox *lara_only_toggle = nullptr;
+	ProgressBar *load_progress_bar = nullptr;
+
+	void _set_loading(bool p_loading) {
+		reload_level_button->set_disabled(p_loading);
+		lara_only_toggle->set_disabled(p_loading);
+		cancel_load_button->set_visible(p_loading);
+		load_progress_bar->set_visible(p_loading);
+	}
+
+	TRLevel *_get_loading_level_node() const {
+		return Object::cast_to<TRLevel>(ObjectDB::get_instance(loading_level_id));
+	}
 
 	void _button_pressed() {
 		ERR_FAIL_COND(!level_node);
+		ERR_FAIL_COND(_get_loading_level_node());
+
+		TRLevel *loading_level_node = level_node;
+		loading_level_id = loading_level_node->get_instance_id();
+		loading_level_node->connect("load_progress", callable_mp(this, &TRLevelEditorPlugin::_load_progress));
+		loading_level_node->connect("load_finished", callable_mp(this, &TRLevelEditorPlugin::_load_finished), CONNECT_ONE_SHOT);
+
+		load_progress_bar->set_value(0.0);
+		_set_loading(true);
+
+		if (loading_level_node->load_level_async(lara_only_toggle->is_pressed()) != OK) {
+			loading_level_node->disconnect("load_finished", callable_mp(this, &TRLevelEditorPlugin::_load_finished));
+			_load_finished(false);
+		}
+	}
+
+	void _cancel_button_pressed() {
+		TRLevel *loading_level_node = _get_loading_level_node();
+		if (loading_level_node) {
+			loading_level_node->cancel_level_load();
+		}
+	}
+
+	void _load_progress(const String &p_phase, real_t p_progress) {
+		load_progress_bar->set_value(p_progress * 100.0);
+		load_progress_bar->set_tooltip_text(p_phase.capitalize());
+	}
+
+	void _load_finished(bool p_success) {
+		TRLevel *loading_level_node = _get_loading_level_node();
+		if (loading_level_node) {
+			loading_level_node->disconnect("load_progress", callable_mp(this, &TRLevelEditorPlugin::_load_progress));
+		}
+		loading_level_id = ObjectID();
+
+		_set_loading(false);
 
-		level_node->clear_level();
-		level_node->load_level(lara_only_toggle->is_pressed());
-		get_editor_interface()->mark_scene_as_unsaved();
+		if (p_success) {
+			get_editor_interface()->mark_scene_as_unsaved();
+		}
 	}
 public:
 	virtual String get_plugin_name() const override { return "TRLevel"; }
@@ -36,6 +87,11 @@ public:
 
 	void edit(Object* p_object) {
 		level_node = Object::cast_to<TRLevel>(p_object);
+
+		// The level being loaded may have been freed along with its scene.
+		if (loading_level_id.is_valid() && !_get_loading_level_node()) {
+			_load_finished(false);
+		}
 	}
 
 	bool handles(Object* p_object) const {
@@ -61,8 +117,20 @@ public:
 		lara_only_toggle = memnew(CheckBox);
 		lara_only_toggle->set_text("Lara Only");
 
+		load_progress_bar = memnew(ProgressBar);
+		load_progress_bar->set_custom_minimum_size(Size2(160.0, 0.0));
+		load_progress_bar->set_v_size_flags(Control::SIZE_SHRINK_CENTER);
+		load_progress_bar->hide();
+
+		cancel_load_button = memnew(Button);
+		cancel_load_button->set_text("Cancel");
+		cancel_load_button->connect("pressed", callable_mp(this, &TRLevelEditorPlugin::_cancel_button_pressed));
+		cancel_load_button->hide();
+
 		container->add_child(reload_level_button);
 		container->add_child(lara_only_toggle);
+		container->add_child(load_progress_bar);
+		container->add_child(cancel_load_button);
 
 		container->hide();
 
@@ -82,6 +150,16 @@ public:
 			lara_only_toggle = nullptr;
 		}
 
+		if (load_progress_bar) {
+			load_progress_bar->queue_free();
+			load_progress_bar = nullptr;
+		}
+
+		if (cancel_load_button) {
+			cancel_load_button->queue_free();
+			cancel_load_button = nullptr;
+		}
+
 		if (container) {
 			container->queue_free();
 			container = nullptr;
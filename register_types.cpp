@@ -1,6 +1,14 @@
 #include "register_types.h"
 #include <editor/editor_node.h>
 #include "tr_level_importer.hpp"
+#include "tr_resource_cache.hpp"
+#include "tr_level_collision.hpp"
+#include "tr_room_activation.hpp"
+#include "tr_room_lighting.hpp"
+#include "tr_room_visibility.hpp"
+#include "tr_sound_sources.hpp"
+
+static TRResourceCache *tr_resource_cache = nullptr;
 
 #ifdef IS_MODULE
 void initialize_tr_lib_module(ModuleInitializationLevel p_level) {
@@ -10,6 +18,13 @@ void gdextension_initialize(ModuleInitializationLevel p_level) {
 	if (p_level == MODULE_INITIALIZATION_LEVEL_SCENE) {
 		ClassDB::register_class<TRLevel>();
 		ClassDB::register_class<TRLevelData>();
+		ClassDB::register_class<TRRoomVisibility>();
+		ClassDB::register_class<TRRoomLighting>();
+		ClassDB::register_class<TRLevelCollision>();
+		ClassDB::register_class<TRSoundSources>();
+		ClassDB::register_class<TRRoomActivation>();
+
+		tr_resource_cache = memnew(TRResourceCache);
 
 #ifdef TR_LIB_EXTERNAL_PLUGIN
 		EditorPlugins::add_by_type<TRLevelEditorPlugin>();
@@ -23,6 +38,10 @@ void uninitialize_tr_lib_module(ModuleInitializationLevel p_level) {
 void gdextension_terminate(ModuleInitializationLevel p_level) {
 #endif
 	if (p_level == MODULE_INITIALIZATION_LEVEL_SCENE) {
+		if (tr_resource_cache) {
+			memdelete(tr_resource_cache);
+			tr_resource_cache = nullptr;
+		}
 	}
 }
 
@@ -0,0 +1,207 @@
+# Headless load benchmark for a directory of level files.
+#
+# Usage:
+#   godot --headless --script tools/benchmark_levels.gd -- --corpus=<dir> [--iterations=5] [--output=results.json] [--baseline=previous.json] [--static-mesh-batching=none|per_room|global|merged]
+#
+# Every .phd/.tr2/.tr4 file under the corpus directory is loaded through
+# TRLevel.load_level the given number of times. The per-phase timings from
+# TRLevel.get_load_statistics() are reduced to min/median/p95 and written as
+# JSON together with the peak resident set size of the process. Passing a
+# baseline file from an earlier run prints the relative change of each median.
+# The node and draw call counts of every generated scene are reported too; with
+# a static mesh batching mode other than none, each level is loaded once more
+# without batching so the counts can be compared before and after.
+extends SceneTree
+
+const LEVEL_EXTENSIONS = ["phd", "tr2", "tr4"]
+const STATIC_MESH_BATCHING_MODES = ["none", "per_room", "global", "merged"]
+
+var last_scene_statistics := {}
+
+
+func _initialize() -> void:
+	var args := _parse_args(OS.get_cmdline_user_args())
+	if not args.has("corpus"):
+		printerr("benchmark_levels: --corpus=<dir> is required.")
+		quit(1)
+		return
+
+	var iterations := int(args.get("iterations", "5"))
+	var static_mesh_batching := STATIC_MESH_BATCHING_MODES.find(args.get("static-mesh-batching", "none"))
+	if static_mesh_batching < 0:
+		printerr("benchmark_levels: unknown --static-mesh-batching mode.")
+		quit(1)
+		return
+
+	var level_paths := _find_levels(args["corpus"])
+	level_paths.sort()
+	if level_paths.is_empty():
+		printerr("benchmark_levels: no level files found under " + args["corpus"])
+		quit(1)
+		return
+
+	var levels := {}
+	var corpus_samples := {}
+	var scenes := {}
+
+	for iteration in iterations:
+		var corpus_iteration := {}
+		for level_path in level_paths:
+			var samples: Dictionary = levels.get(level_path, {})
+			var phases := _load_once(level_path, static_mesh_batching)
+			scenes[level_path] = {"after": last_scene_statistics}
+			for phase in phases:
+				if not samples.has(phase):
+					samples[phase] = []
+				samples[phase].append(phases[phase])
+				corpus_iteration[phase] = corpus_iteration.get(phase, 0) + phases[phase]
+			levels[level_path] = samples
+
+		for phase in corpus_iteration:
+			if not corpus_samples.has(phase):
+				corpus_samples[phase] = []
+			corpus_samples[phase].append(corpus_iteration[phase])
+
+	for level_path in level_paths:
+		if static_mesh_batching == 0:
+			scenes[level_path]["before"] = scenes[level_path]["after"]
+		else:
+			_load_once(level_path, 0)
+			scenes[level_path]["before"] = last_scene_statistics
+
+	var report := {
+		"engine_version": Engine.get_version_info()["string"],
+		"iterations": iterations,
+		"level_count": level_paths.size(),
+		"peak_rss_bytes": _get_peak_rss_bytes(),
+		"engine_peak_memory_bytes": OS.get_static_memory_peak_usage(),
+		"corpus": _summarize(corpus_samples),
+		"levels": {},
+		"static_mesh_batching": STATIC_MESH_BATCHING_MODES[static_mesh_batching],
+		"scenes": scenes,
+	}
+	for level_path in levels:
+		report["levels"][level_path] = _summarize(levels[level_path])
+
+	var json := JSON.stringify(report, "\t")
+	print(json)
+
+	if args.has("output"):
+		var file := FileAccess.open(args["output"], FileAccess.WRITE)
+		if file:
+			file.store_string(json)
+		else:
+			printerr("benchmark_levels: could not write " + args["output"])
+
+	if args.has("baseline"):
+		_compare_with_baseline(report, args["baseline"])
+
+	_print_scene_counts(scenes)
+
+	quit(0)
+
+
+func _parse_args(p_args: PackedStringArray) -> Dictionary:
+	var args := {}
+	for arg in p_args:
+		if arg.begins_with("--") and arg.contains("="):
+			args[arg.substr(2, arg.find("=") - 2)] = arg.substr(arg.find("=") + 1)
+	return args
+
+
+func _find_levels(p_directory: String) -> PackedStringArray:
+	var level_paths := PackedStringArray()
+	var dir := DirAccess.open(p_directory)
+	if not dir:
+		return level_paths
+
+	for sub_directory in dir.get_directories():
+		level_paths.append_array(_find_levels(p_directory.path_join(sub_directory)))
+	for file_name in dir.get_files():
+		if LEVEL_EXTENSIONS.has(file_name.get_extension().to_lower()):
+			level_paths.append(p_directory.path_join(file_name))
+
+	return level_paths
+
+
+# Returns the inclusive duration in microseconds of every phase for one load.
+func _load_once(p_level_path: String, p_static_mesh_batching: int) -> Dictionary:
+	var level := TRLevel.new()
+	level.level_path = p_level_path
+	level.static_mesh_batching = p_static_mesh_batching
+
+	var start_usec := Time.get_ticks_usec()
+	level.load_level(false)
+	var wall_usec := Time.get_ticks_usec() - start_usec
+
+	var phases := {"wall": wall_usec}
+	var statistics: Dictionary = level.get_load_statistics()
+	var phase_statistics: Dictionary = statistics.get("phases", {})
+	for phase in phase_statistics:
+		phases[phase] = phase_statistics[phase]["total_usec"]
+	last_scene_statistics = statistics.get("scene", {})
+
+	level.free()
+	return phases
+
+
+func _summarize(p_samples: Dictionary) -> Dictionary:
+	var summary := {}
+	for phase in p_samples:
+		var values: Array = p_samples[phase].duplicate()
+		values.sort()
+		var p95_index := clampi(int(ceil(values.size() * 0.95)) - 1, 0, values.size() - 1)
+		summary[phase] = {
+			"min_usec": values[0],
+			"median_usec": _median(values),
+			"p95_usec": values[p95_index],
+			"samples": values.size(),
+		}
+	return summary
+
+
+func _median(p_sorted_values: Array) -> float:
+	var count := p_sorted_values.size()
+	if count % 2 == 1:
+		return p_sorted_values[count / 2]
+	return (p_sorted_values[count / 2 - 1] + p_sorted_values[count / 2]) / 2.0
+
+
+# Peak resident set size from procfs; falls back to Godot's own allocator peak elsewhere.
+func _get_peak_rss_bytes() -> int:
+	var status := FileAccess.open("/proc/self/status", FileAccess.READ)
+	if status:
+		while not status.eof_reached():
+			var line := status.get_line()
+			if line.begins_with("VmHWM:"):
+				return int(line.get_slice(":", 1).strip_edges().get_slice(" ", 0)) * 1024
+	return OS.get_static_memory_peak_usage()
+
+
+func _compare_with_baseline(p_report: Dictionary, p_baseline_path: String) -> void:
+	var baseline = JSON.parse_string(FileAccess.get_file_as_string(p_baseline_path))
+	if typeof(baseline) != TYPE_DICTIONARY:
+		printerr("benchmark_levels: could not read baseline " + p_baseline_path)
+		return
+
+	print("phase\tbaseline_median_usec\tmedian_usec\tchange")
+	var baseline_corpus: Dictionary = baseline.get("corpus", {})
+	for phase in p_report["corpus"]:
+		if not baseline_corpus.has(phase):
+			continue
+		var before: float = baseline_corpus[phase]["median_usec"]
+		var after: float = p_report["corpus"][phase]["median_usec"]
+		var change := 0.0
+		if before > 0.0:
+			change = (after - before) / before * 100.0
+		print("%s\t%d\t%d\t%+.1f%%" % [phase, before, after, change])
+
+	print("peak_rss_bytes\t%d\t%d" % [baseline.get("peak_rss_bytes", 0), p_report["peak_rss_bytes"]])
+
+
+func _print_scene_counts(p_scenes: Dictionary) -> void:
+	print("level\tnodes_before\tnodes_after\tdraw_calls_before\tdraw_calls_after")
+	for level_path in p_scenes:
+		var before: Dictionary = p_scenes[level_path]["before"]
+		var after: Dictionary = p_scenes[level_path]["after"]
+		print("%s\t%d\t%d\t%d\t%d" % [level_path.get_file(), before.get("nodes", 0), after.get("nodes", 0), before.get("draw_calls", 0), after.get("draw_calls", 0)])
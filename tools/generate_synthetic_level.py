@@ -0,0 +1,871 @@
+#!/usr/bin/env python3
+# Writes synthetic TR1/TR2/TR4 level files for scale testing the parser and
+# scene builder without any game data.
+#
+# Usage:
+#   python3 tools/generate_synthetic_level.py --format=tr2 --rooms=2000 --output=stress.tr2
+#
+# Rooms are laid out on a square grid and connected to their grid neighbours
+# through wall portals (at most four per room). Every room has a tessellated
+# floor and ceiling, one light and optionally a number of static meshes.
+# Moveables are chains of box meshes with a configurable number of bones,
+# animations and frames per animation. Entities are spread round-robin over
+# the rooms and cycle through the moveable types.
+#
+# The layout follows the readers in tr_level.cpp section by section; anything
+# the loader skips or does not use (sprites, cameras, boxes, zones, sounds) is
+# written as an empty table.
+
+import argparse
+import math
+import struct
+import sys
+import zlib
+
+TR_TEXTILE_SIZE = 256
+TR_SQUARE_SIZE = 1024
+TR_CLICK_SIZE = 256
+
+TR_ROOM_HEIGHT = 8 * TR_CLICK_SIZE
+TR_WALL_SECTOR = -127
+TR_NO_ROOM = 255
+
+TR_CHART_SIZE = 64
+TR_CHARTS_PER_PAGE = (TR_TEXTILE_SIZE // TR_CHART_SIZE) ** 2
+
+VERSIONS = {
+	"tr1": 0x00000020,
+	"tr2": 0x0000002D,
+	"tr4": 0x00345254,
+}
+
+EXTENSIONS = {
+	"tr1": ".phd",
+	"tr2": ".tr2",
+	"tr4": ".tr4",
+}
+
+
+class Writer:
+	def __init__(self):
+		self.parts = []
+		self.size = 0
+
+	def put(self, fmt, *values):
+		data = struct.pack("<" + fmt, *values)
+		self.parts.append(data)
+		self.size += len(data)
+
+	def put_bytes(self, data):
+		self.parts.append(data)
+		self.size += len(data)
+
+	def u8(self, value):
+		self.put("B", value)
+
+	def s8(self, value):
+		self.put("b", value)
+
+	def u16(self, value):
+		self.put("H", value)
+
+	def s16(self, value):
+		self.put("h", value)
+
+	def u32(self, value):
+		self.put("I", value)
+
+	def s32(self, value):
+		self.put("i", value)
+
+	def f32(self, value):
+		self.put("f", value)
+
+	def getvalue(self):
+		return b"".join(self.parts)
+
+
+def fail(message):
+	sys.stderr.write("generate_synthetic_level: " + message + "\n")
+	sys.exit(1)
+
+
+# Texture pages
+
+def chart_color(chart_index):
+	# Distinct, saturated colour per chart so content-based dedup has something to tell apart.
+	hue = (chart_index * 0.618033988749895) % 1.0
+	i = int(hue * 6.0)
+	f = hue * 6.0 - i
+	r, g, b = [(1, f, 0), (1 - f, 1, 0), (0, 1, f), (0, 1 - f, 1), (f, 0, 1), (1, 0, 1 - f)][i % 6]
+	return int(r * 255), int(g * 255), int(b * 255)
+
+
+def page_texels(page_index):
+	# Yields (x, y, r, g, b, alpha) for every texel of a page. Every chart gets a
+	# checker pattern, and every fourth chart a transparent cutout in one corner.
+	for y in range(TR_TEXTILE_SIZE):
+		for x in range(TR_TEXTILE_SIZE):
+			chart_index = page_index * TR_CHARTS_PER_PAGE + (y // TR_CHART_SIZE) * (TR_TEXTILE_SIZE // TR_CHART_SIZE) + (x // TR_CHART_SIZE)
+			r, g, b = chart_color(chart_index)
+			if ((x // 8) + (y // 8)) % 2:
+				r, g, b = r // 2, g // 2, b // 2
+			local_x = x % TR_CHART_SIZE
+			local_y = y % TR_CHART_SIZE
+			alpha = not (chart_index % 4 == 3 and local_x < 16 and local_y < 16)
+			yield x, y, r, g, b, alpha
+
+
+def build_palette():
+	# 6-bit VGA palette. Index 0 is the transparent colour, the rest is a 6x6x7 colour cube.
+	palette = [(0, 0, 0)]
+	for r in range(6):
+		for g in range(6):
+			for b in range(7):
+				palette.append((r * 63 // 5, g * 63 // 5, b * 63 // 6))
+	palette = palette[:256]
+	while len(palette) < 256:
+		palette.append((63, 63, 63))
+	return palette
+
+
+def nearest_palette_index(palette, r, g, b):
+	best_index = 1
+	best_distance = None
+	for index in range(1, len(palette)):
+		pr, pg, pb = palette[index]
+		distance = (pr * 4 - r) ** 2 + (pg * 4 - g) ** 2 + (pb * 4 - b) ** 2
+		if best_distance is None or distance < best_distance:
+			best_index = index
+			best_distance = distance
+	return best_index
+
+
+def build_page_8(page_index, palette, lookup):
+	page = bytearray(TR_TEXTILE_SIZE * TR_TEXTILE_SIZE)
+	for x, y, r, g, b, alpha in page_texels(page_index):
+		if not alpha:
+			continue
+		key = (r, g, b)
+		index = lookup.get(key)
+		if index is None:
+			index = nearest_palette_index(palette, r, g, b)
+			lookup[key] = index
+		page[y * TR_TEXTILE_SIZE + x] = index
+	return bytes(page)
+
+
+def build_page_16(page_index):
+	page = bytearray(TR_TEXTILE_SIZE * TR_TEXTILE_SIZE * 2)
+	for x, y, r, g, b, alpha in page_texels(page_index):
+		pixel = ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)
+		if alpha:
+			pixel |= 0x8000
+		struct.pack_into("<H", page, (y * TR_TEXTILE_SIZE + x) * 2, pixel)
+	return bytes(page)
+
+
+def build_page_32(page_index):
+	page = bytearray(TR_TEXTILE_SIZE * TR_TEXTILE_SIZE * 4)
+	for x, y, r, g, b, alpha in page_texels(page_index):
+		offset = (y * TR_TEXTILE_SIZE + x) * 4
+		page[offset:offset + 4] = bytes((b, g, r, 0xff if alpha else 0x00))
+	return bytes(page)
+
+
+# Level description
+
+class Level:
+	def __init__(self, args):
+		self.format = args.format
+		self.room_count = args.rooms
+		self.room_sectors = args.room_sectors
+		self.portals_per_room = args.portals_per_room
+		self.statics_per_room = args.statics_per_room
+		self.entity_count = args.entities
+		self.moveable_count = args.moveables
+		self.bones_per_moveable = args.bones_per_moveable
+		self.animations_per_moveable = args.animations_per_moveable
+		self.animation_frames = args.animation_frames
+		self.texture_pages = args.texture_pages
+
+		# Floor and ceiling are each a (segments + 1)^2 vertex grid.
+		self.segments = max(1, int(math.sqrt(max(args.vertices_per_room, 8) / 2.0)) - 1)
+
+		self.grid_columns = max(1, int(math.ceil(math.sqrt(self.room_count))))
+		self.texture_info_count = self.texture_pages * TR_CHARTS_PER_PAGE
+
+		# One portal record in floor data per target room, index 0 is the "no data" entry.
+		self.floor_data = [0]
+		self.portal_floor_data_index = {}
+
+	def room_grid_position(self, room_index):
+		return room_index % self.grid_columns, room_index // self.grid_columns
+
+	def room_neighbours(self, room_index):
+		column, row = self.room_grid_position(room_index)
+		neighbours = []
+		# East, west, south, north.
+		for direction, (dx, dz) in enumerate(((1, 0), (-1, 0), (0, 1), (0, -1))):
+			neighbour_column = column + dx
+			neighbour_row = row + dz
+			if neighbour_column < 0 or neighbour_column >= self.grid_columns or neighbour_row < 0:
+				continue
+			neighbour = neighbour_row * self.grid_columns + neighbour_column
+			if neighbour >= self.room_count:
+				continue
+			neighbours.append((direction, neighbour))
+		return neighbours[:self.portals_per_room]
+
+	def room_world_origin(self, room_index):
+		column, row = self.room_grid_position(room_index)
+		return column * self.room_sectors * TR_SQUARE_SIZE, row * self.room_sectors * TR_SQUARE_SIZE
+
+	def get_portal_floor_data_index(self, room_index):
+		index = self.portal_floor_data_index.get(room_index)
+		if index is None:
+			index = len(self.floor_data)
+			# Portal function with the end-of-list bit set, followed by the room number.
+			self.floor_data.append(0x8001)
+			self.floor_data.append(room_index)
+			self.portal_floor_data_index[room_index] = index
+		return index
+
+	def mesh_bone_count(self):
+		return self.moveable_count * self.bones_per_moveable
+
+	def static_mesh_index(self):
+		# A single box mesh after all moveable meshes is shared by every static.
+		return self.mesh_bone_count()
+
+	def frame_words(self):
+		# Bounding box, root offset, the TR1 rotation count, then two words per bone.
+		words = 6 + 3 + 2 * self.bones_per_moveable
+		if self.format == "tr1":
+			words += 1
+		return words
+
+
+# Rooms
+
+def write_room_vertex(w, level, x, y, z, shade):
+	w.s16(x)
+	w.s16(y)
+	w.s16(z)
+	w.s16(shade)
+	if level.format == "tr2":
+		w.u16(0)
+		w.s16(shade)
+	elif level.format == "tr4":
+		# TR4 lights room vertices from the second value, a 15-bit colour.
+		w.u16(0)
+		w.s16(0x4210)
+
+
+def write_room_data(w, level, room_index):
+	data = Writer()
+	size = level.room_sectors * TR_SQUARE_SIZE
+	points = level.segments + 1
+
+	# Floor then ceiling grid, shaded with a gradient across the room.
+	data.s16(points * points * 2)
+	for y in (0, -TR_ROOM_HEIGHT):
+		for j in range(points):
+			for i in range(points):
+				shade = 0x0800 + ((i + j) * 0x1000 // (points * 2))
+				write_room_vertex(data, level, i * size // level.segments, y, j * size // level.segments, shade)
+
+	data.s16(level.segments * level.segments * 2)
+	for surface in range(2):
+		base = surface * points * points
+		for j in range(level.segments):
+			for i in range(level.segments):
+				a = base + j * points + i
+				b = a + 1
+				c = a + points + 1
+				d = a + points
+				if surface == 1:
+					a, b, c, d = a, d, c, b
+				texture_info = (room_index + i + j) % level.texture_info_count
+				data.s16(a)
+				data.s16(b)
+				data.s16(c)
+				data.s16(d)
+				data.u16(texture_info)
+
+	data.s16(0)
+	data.s16(0)
+
+	room_data = data.getvalue()
+	if len(room_data) % 2:
+		room_data += b"\0"
+	w.u32(len(room_data) // 2)
+	w.put_bytes(room_data)
+
+
+def write_room_portals(w, level, room_index):
+	size = level.room_sectors * TR_SQUARE_SIZE
+	neighbours = level.room_neighbours(room_index)
+
+	w.s16(len(neighbours))
+	for direction, neighbour in neighbours:
+		w.u16(neighbour)
+		if direction == 0:
+			normal = (-1, 0, 0)
+			vertices = [(size, 0, 0), (size, 0, size), (size, -TR_ROOM_HEIGHT, size), (size, -TR_ROOM_HEIGHT, 0)]
+		elif direction == 1:
+			normal = (1, 0, 0)
+			vertices = [(0, 0, size), (0, 0, 0), (0, -TR_ROOM_HEIGHT, 0), (0, -TR_ROOM_HEIGHT, size)]
+		elif direction == 2:
+			normal = (0, 0, -1)
+			vertices = [(size, 0, size), (0, 0, size), (0, -TR_ROOM_HEIGHT, size), (size, -TR_ROOM_HEIGHT, size)]
+		else:
+			normal = (0, 0, 1)
+			vertices = [(0, 0, 0), (size, 0, 0), (size, -TR_ROOM_HEIGHT, 0), (0, -TR_ROOM_HEIGHT, 0)]
+		for value in normal:
+			w.s16(value)
+		for vertex in vertices:
+			for value in vertex:
+				w.s16(value)
+
+
+def write_room_sectors(w, level, room_index):
+	count = level.room_sectors
+	portal_sectors = {}
+	for direction, neighbour in level.room_neighbours(room_index):
+		index = level.get_portal_floor_data_index(neighbour)
+		for k in range(1, count - 1):
+			if direction == 0:
+				portal_sectors[(count - 1, k)] = index
+			elif direction == 1:
+				portal_sectors[(0, k)] = index
+			elif direction == 2:
+				portal_sectors[(k, count - 1)] = index
+			else:
+				portal_sectors[(k, 0)] = index
+
+	w.u16(count)
+	w.u16(count)
+	# Sectors are stored column-major: x outer, z inner.
+	for x in range(count):
+		for z in range(count):
+			border = x == 0 or z == 0 or x == count - 1 or z == count - 1
+			floor_data_index = portal_sectors.get((x, z), 0)
+			w.u16(floor_data_index)
+			w.s16(-1)
+			w.u8(TR_NO_ROOM)
+			if border:
+				w.s8(TR_WALL_SECTOR)
+			else:
+				w.s8(0)
+			w.u8(TR_NO_ROOM)
+			if border:
+				w.s8(TR_WALL_SECTOR)
+			else:
+				w.s8(-TR_ROOM_HEIGHT // TR_CLICK_SIZE)
+
+
+def write_room_light(w, level, x, y, z):
+	w.s32(x)
+	w.s32(y)
+	w.s32(z)
+	if level.format == "tr4":
+		w.u8(255)
+		w.u8(240)
+		w.u8(220)
+		w.u8(1)
+		w.u8(0)
+		w.u8(31)
+		w.f32(1024.0)
+		w.f32(4096.0)
+		w.f32(0.0)
+		w.f32(0.0)
+		w.f32(0.0)
+		w.f32(0.0)
+		w.f32(0.0)
+	else:
+		w.u16(0x1000)
+		if level.format == "tr2":
+			w.u16(0x1000)
+		w.u32(TR_SQUARE_SIZE * 4)
+		if level.format == "tr2":
+			w.u32(TR_SQUARE_SIZE * 4)
+
+
+def write_room(w, level, room_index):
+	size = level.room_sectors * TR_SQUARE_SIZE
+	origin_x, origin_z = level.room_world_origin(room_index)
+
+	w.s32(origin_x)
+	w.s32(origin_z)
+	w.s32(0)
+	w.s32(-TR_ROOM_HEIGHT)
+
+	write_room_data(w, level, room_index)
+	write_room_portals(w, level, room_index)
+	write_room_sectors(w, level, room_index)
+
+	if level.format == "tr4":
+		w.u8(0xff)
+		w.u8(0x60)
+		w.u8(0x60)
+		w.u8(0x60)
+	elif level.format == "tr2":
+		w.u16(0x0800)
+		w.u16(0x0800)
+		w.s16(0)
+	else:
+		w.u16(0x0800)
+
+	w.u16(1)
+	write_room_light(w, level, origin_x + size // 2, -TR_ROOM_HEIGHT // 2, origin_z + size // 2)
+
+	w.u16(level.statics_per_room)
+	for i in range(level.statics_per_room):
+		# Statics on a diagonal inside the walls, rotated in quarter turns.
+		t = (i + 1) / (level.statics_per_room + 1)
+		w.s32(origin_x + TR_SQUARE_SIZE + int(t * (size - 2 * TR_SQUARE_SIZE)))
+		w.s32(0)
+		w.s32(origin_z + TR_SQUARE_SIZE + int((1.0 - t) * (size - 2 * TR_SQUARE_SIZE)))
+		w.u16((i % 4) * 0x4000)
+		w.u16(0x1000)
+		if level.format != "tr1":
+			w.u16(0x1000)
+		w.u16(0)
+
+	w.s16(-1)
+	w.u16(0)
+	if level.format == "tr4":
+		w.u8(0)
+		w.u8(0)
+		w.u8(0)
+
+
+# Meshes and animation
+
+def write_box_mesh(w, level, half_x, half_y, half_z, texture_info_base):
+	w.s16(0)
+	w.s16(-half_y)
+	w.s16(0)
+	w.s32(max(half_x, half_y, half_z))
+
+	corners = []
+	for y in (0, -2 * half_y):
+		for z in (-half_z, half_z):
+			for x in (-half_x, half_x):
+				corners.append((x, y, z))
+
+	w.s16(len(corners))
+	for x, y, z in corners:
+		w.s16(x)
+		w.s16(y)
+		w.s16(z)
+
+	w.s16(len(corners))
+	for x, y, z in corners:
+		length = math.sqrt(x * x + (y + half_y) ** 2 + z * z) or 1.0
+		w.s16(int(x / length * 16384))
+		w.s16(int((y + half_y) / length * 16384))
+		w.s16(int(z / length * 16384))
+
+	faces = [
+		(0, 1, 3, 2), (4, 6, 7, 5),
+		(0, 4, 5, 1), (2, 3, 7, 6),
+		(0, 2, 6, 4), (1, 5, 7, 3),
+	]
+	w.s16(len(faces))
+	for face_index, face in enumerate(faces):
+		for index in face:
+			w.s16(index)
+		w.u16((texture_info_base + face_index) % level.texture_info_count)
+		if level.format == "tr4":
+			w.s16(0)
+
+	w.s16(0)
+
+	if level.format != "tr4":
+		w.s16(0)
+		w.s16(0)
+
+
+def write_meshes(w, level):
+	mesh_data = Writer()
+	mesh_pointers = []
+
+	for moveable in range(level.moveable_count):
+		for bone in range(level.bones_per_moveable):
+			# Each mesh has its own dimensions so content-addressed caches do not fold them together.
+			mesh_pointers.append(mesh_data.size)
+			write_box_mesh(mesh_data, level, 64 + (moveable % 32) * 4, 96 + bone * 2, 48 + (moveable // 32) % 32, moveable + bone)
+
+	mesh_pointers.append(mesh_data.size)
+	write_box_mesh(mesh_data, level, 256, 512, 256, 0)
+
+	buffer = mesh_data.getvalue()
+	if len(buffer) % 2:
+		buffer += b"\0"
+	w.s32(len(buffer) // 2)
+	w.put_bytes(buffer)
+
+	w.s32(len(mesh_pointers))
+	for pointer in mesh_pointers:
+		w.s32(pointer)
+
+
+def write_animation_frame(frames, level, moveable, animation, frame):
+	phase = (frame / max(1, level.animation_frames)) * 2.0 * math.pi
+
+	bounds = (-128, 128, -1024, 0, -128, 128)
+	for value in bounds:
+		frames.s16(value)
+
+	frames.s16(0)
+	frames.s16(-512 + int(math.sin(phase) * 32))
+	frames.s16(0)
+
+	if level.format == "tr1":
+		frames.s16(level.bones_per_moveable)
+
+	for bone in range(level.bones_per_moveable):
+		# Full three-axis rotations in 10-bit angles; the top two bits stay clear.
+		x = int((math.sin(phase + bone) * 0.25 + 0.25) * 1023) & 0x3ff
+		y = ((animation * 64) + bone * 8) & 0x3ff
+		z = int((math.cos(phase + bone) * 0.125 + 0.125) * 1023) & 0x3ff
+		rotation = (x << 20) | (y << 10) | z
+		if level.format == "tr1":
+			frames.u16(rotation & 0xffff)
+			frames.u16(rotation >> 16)
+		else:
+			frames.u16(rotation >> 16)
+			frames.u16(rotation & 0xffff)
+
+
+def write_animation_data(w, level):
+	animation_count = level.moveable_count * level.animations_per_moveable
+	frame_words = level.frame_words()
+
+	frames = Writer()
+	animation_frame_offsets = []
+	for moveable in range(level.moveable_count):
+		for animation in range(level.animations_per_moveable):
+			animation_frame_offsets.append(frames.size)
+			for frame in range(level.animation_frames):
+				write_animation_frame(frames, level, moveable, animation, frame)
+
+	w.s32(animation_count)
+	for moveable in range(level.moveable_count):
+		for animation in range(level.animations_per_moveable):
+			animation_index = moveable * level.animations_per_moveable + animation
+			w.s32(animation_frame_offsets[animation_index])
+			w.u8(1)
+			w.u8(frame_words)
+			w.s16(animation)
+			w.s32(0)
+			w.s32(0)
+			if level.format == "tr4":
+				w.s32(0)
+				w.s32(0)
+			w.s16(0)
+			w.s16(level.animation_frames - 1)
+			w.s16(animation_index)
+			w.s16(0)
+			w.s16(0)
+			w.s16(0)
+			w.s16(0)
+			w.s16(0)
+
+	# State changes, dispatches and commands.
+	w.s32(0)
+	w.s32(0)
+	w.s32(0)
+
+	# Mesh tree: every bone hangs off its predecessor.
+	w.s32(level.moveable_count * max(0, level.bones_per_moveable - 1) * 4)
+	for moveable in range(level.moveable_count):
+		for bone in range(1, level.bones_per_moveable):
+			w.s32(0)
+			w.s32(0)
+			w.s32(-192)
+			w.s32(0)
+
+	frame_buffer = frames.getvalue()
+	w.s32(len(frame_buffer) // 2)
+	w.put_bytes(frame_buffer)
+
+	w.s32(level.moveable_count)
+	for moveable in range(level.moveable_count):
+		w.u32(moveable)
+		w.s16(level.bones_per_moveable)
+		w.s16(moveable * level.bones_per_moveable)
+		w.s32(moveable * max(0, level.bones_per_moveable - 1) * 4)
+		w.s32(animation_frame_offsets[moveable * level.animations_per_moveable] if level.animations_per_moveable else 0)
+		if level.animations_per_moveable:
+			w.s16(moveable * level.animations_per_moveable)
+		else:
+			w.s16(-1)
+
+
+def write_static_infos(w, level):
+	w.s32(1)
+	w.u32(0)
+	w.u16(level.static_mesh_index())
+	for _ in range(2):
+		w.s16(-256)
+		w.s16(256)
+		w.s16(-1024)
+		w.s16(0)
+		w.s16(-256)
+		w.s16(256)
+	w.u16(0)
+
+
+def write_texture_infos(w, level):
+	w.s32(level.texture_info_count)
+	charts_per_row = TR_TEXTILE_SIZE // TR_CHART_SIZE
+	for i in range(level.texture_info_count):
+		page = i // TR_CHARTS_PER_PAGE
+		chart = i % TR_CHARTS_PER_PAGE
+		left = (chart % charts_per_row) * TR_CHART_SIZE
+		top = (chart // charts_per_row) * TR_CHART_SIZE
+		right = left + TR_CHART_SIZE - 1
+		bottom = top + TR_CHART_SIZE - 1
+
+		# Charts with a cutout use the alpha-tested draw type.
+		w.s16(1 if chart % 4 == 3 else 0)
+		w.u16(page)
+		if level.format == "tr4":
+			w.s16(0)
+		for u, v in ((left, top), (right, top), (right, bottom), (left, bottom)):
+			w.u16(u << 8)
+			w.u16(v << 8)
+		if level.format == "tr4":
+			w.u32(0)
+			w.u32(0)
+			w.u32(TR_CHART_SIZE - 1)
+			w.u32(TR_CHART_SIZE - 1)
+
+
+def write_entities(w, level):
+	w.s32(level.entity_count)
+	for i in range(level.entity_count):
+		room_index = i % level.room_count
+		slot = i // level.room_count
+		origin_x, origin_z = level.room_world_origin(room_index)
+		inner = level.room_sectors - 2
+		sector_x = 1 + slot % inner
+		sector_z = 1 + (slot // inner) % inner
+
+		w.s16(i % level.moveable_count)
+		w.s16(room_index)
+		w.s32(origin_x + sector_x * TR_SQUARE_SIZE + TR_SQUARE_SIZE // 2)
+		w.s32(0)
+		w.s32(origin_z + sector_z * TR_SQUARE_SIZE + TR_SQUARE_SIZE // 2)
+		w.u16((i * 0x2000) & 0xffff)
+		w.s16(-1)
+		if level.format == "tr2":
+			w.s16(-1)
+		elif level.format == "tr4":
+			w.s16(0)
+		w.u16(0x3e00)
+
+
+# Level body, in the order TRLevel::load_level_data reads it.
+
+def write_level_body(w, level, palette):
+	w.s32(0)
+
+	w.u16(level.room_count)
+	for room_index in range(level.room_count):
+		write_room(w, level, room_index)
+
+	w.u32(len(level.floor_data))
+	for value in level.floor_data:
+		w.u16(value)
+
+	write_meshes(w, level)
+	write_animation_data(w, level)
+	write_static_infos(w, level)
+
+	if level.format in ("tr1", "tr2"):
+		write_texture_infos(w, level)
+
+	if level.format == "tr4":
+		w.put_bytes(b"SPR")
+
+	# Sprite textures and sprite sequences.
+	w.s32(0)
+	w.s32(0)
+
+	# Cameras.
+	w.s32(0)
+
+	if level.format == "tr4":
+		w.u32(0)
+
+	# Sound sources.
+	w.s32(0)
+
+	# Boxes, overlaps (zones follow with zero length).
+	w.s32(0)
+	w.s32(0)
+
+	# Animated textures.
+	w.s32(0)
+	if level.format == "tr4":
+		w.u8(0)
+
+	if level.format == "tr4":
+		w.put_bytes(b"TEX")
+		write_texture_infos(w, level)
+
+	write_entities(w, level)
+
+	if level.format == "tr4":
+		w.u32(0)
+
+	if level.format in ("tr1", "tr2"):
+		w.put_bytes(bytes(32 * TR_TEXTILE_SIZE))
+
+	if level.format == "tr1":
+		for r, g, b in palette:
+			w.u8(r)
+			w.u8(g)
+			w.u8(b)
+
+	if level.format in ("tr1", "tr2"):
+		w.s16(0)
+
+	# Demo data.
+	w.s16(0)
+
+	if level.format != "tr4":
+		for _ in range(256 if level.format == "tr1" else 370):
+			w.s16(-1)
+		w.u32(0)
+		if level.format == "tr1":
+			w.u32(0)
+		w.u32(0)
+	else:
+		w.put_bytes(bytes(6))
+
+
+def write_compressed_block(w, data):
+	compressed = zlib.compress(data)
+	w.u32(len(data))
+	w.u32(len(compressed))
+	w.put_bytes(compressed)
+
+
+def generate(level):
+	w = Writer()
+	w.u32(VERSIONS[level.format])
+
+	palette = build_palette()
+
+	if level.format == "tr1":
+		lookup = {}
+		w.u32(level.texture_pages)
+		for page in range(level.texture_pages):
+			w.put_bytes(build_page_8(page, palette, lookup))
+		write_level_body(w, level, palette)
+	elif level.format == "tr2":
+		for r, g, b in palette:
+			w.u8(r)
+			w.u8(g)
+			w.u8(b)
+		for r, g, b in palette:
+			w.u8(r)
+			w.u8(g)
+			w.u8(b)
+			w.u8(0)
+
+		lookup = {}
+		w.u32(level.texture_pages)
+		for page in range(level.texture_pages):
+			w.put_bytes(build_page_8(page, palette, lookup))
+		for page in range(level.texture_pages):
+			w.put_bytes(build_page_16(page))
+		write_level_body(w, level, palette)
+	else:
+		# All textiles are stored as room textiles; the object and bump page counts are zero.
+		w.u16(level.texture_pages)
+		w.u16(0)
+		w.u16(0)
+
+		write_compressed_block(w, b"".join(build_page_32(page) for page in range(level.texture_pages)))
+		write_compressed_block(w, b"".join(build_page_16(page) for page in range(level.texture_pages)))
+		write_compressed_block(w, bytes(2 * TR_TEXTILE_SIZE * TR_TEXTILE_SIZE * 4))
+
+		body = Writer()
+		write_level_body(body, level, palette)
+		write_compressed_block(w, body.getvalue())
+
+		# No samples.
+		w.u32(0)
+
+	return w.getvalue()
+
+
+def validate(args):
+	# Two floor data words per room for its portal record, addressed by a 16-bit index.
+	if args.rooms < 1 or args.rooms > 0x7fff:
+		fail("--rooms must be between 1 and 32767.")
+	if args.room_sectors < 3 or args.room_sectors * TR_SQUARE_SIZE > 0x7fff:
+		fail("--room-sectors must be between 3 and 31.")
+	if args.portals_per_room < 0 or args.portals_per_room > 4:
+		fail("--portals-per-room must be between 0 and 4.")
+	if args.vertices_per_room < 8 or args.vertices_per_room > 0x7fff:
+		fail("--vertices-per-room must be between 8 and 32767.")
+	if args.moveables < 1 and args.entities > 0:
+		fail("entities need at least one moveable.")
+	if args.moveables > 4096:
+		fail("--moveables is limited to 4096 entity type ids by the loader.")
+	if args.moveables * args.bones_per_moveable + 1 > 0x7fff:
+		fail("moveables * bones-per-moveable must stay below 32767 meshes.")
+	if args.bones_per_moveable < 1 or 9 + 1 + 2 * args.bones_per_moveable > 0xff:
+		fail("--bones-per-moveable must be between 1 and 122.")
+	if args.animation_frames < 1 or args.animation_frames > 0x7fff:
+		fail("--animation-frames must be between 1 and 32767.")
+	if args.moveables * args.animations_per_moveable > 0x7fff:
+		fail("moveables * animations-per-moveable must stay below 32767.")
+	if args.entities > 10240:
+		fail("--entities is limited to 10240 by the loader.")
+	if args.texture_pages < 1 or args.texture_pages * TR_CHARTS_PER_PAGE > 8192:
+		fail("--texture-pages must be between 1 and %d." % (8192 // TR_CHARTS_PER_PAGE))
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Write a synthetic Tomb Raider level for scale testing.")
+	parser.add_argument("--format", choices=sorted(VERSIONS.keys()), default="tr1")
+	parser.add_argument("--output", help="Output path. Defaults to synthetic.<ext> for the chosen format.")
+	parser.add_argument("--rooms", type=int, default=100)
+	parser.add_argument("--room-sectors", type=int, default=8, help="Width and depth of each room in sectors, walls included.")
+	parser.add_argument("--vertices-per-room", type=int, default=162, help="Approximate vertex count, split between floor and ceiling.")
+	parser.add_argument("--portals-per-room", type=int, default=4, help="Portals to grid neighbours, at most 4.")
+	parser.add_argument("--statics-per-room", type=int, default=0)
+	parser.add_argument("--entities", type=int, default=100)
+	parser.add_argument("--moveables", type=int, default=10)
+	parser.add_argument("--bones-per-moveable", type=int, default=8)
+	parser.add_argument("--animations-per-moveable", type=int, default=2)
+	parser.add_argument("--animation-frames", type=int, default=30, help="Frames per animation.")
+	parser.add_argument("--texture-pages", type=int, default=2)
+	args = parser.parse_args()
+
+	validate(args)
+
+	level = Level(args)
+	data = generate(level)
+
+	output = args.output or ("synthetic" + EXTENSIONS[args.format])
+	if not output.lower().endswith(EXTENSIONS[args.format]):
+		# The loader tells TR4 apart from TR5 by the file extension.
+		fail("output for %s must end in %s." % (args.format, EXTENSIONS[args.format]))
+	with open(output, "wb") as f:
+		f.write(data)
+
+	print("%s: %d rooms, %d vertices per room, %d entities, %d moveables, %d bytes" % (
+		output, level.room_count, (level.segments + 1) ** 2 * 2, level.entity_count, level.moveable_count, len(data)))
+
+
+if __name__ == "__main__":
+	main()
@@ -1,4 +1,5 @@
 #include "tr_level.hpp"
+#include "tr_resource_cache.hpp"
 
 #include <core/io/stream_peer_gzip.h>
 #include <core/math/math_funcs.h>
@@ -7,6 +8,7 @@
 #include <scene/3d/bone_attachment_3d.h>
 #include <scene/3d/lightmap_gi.h>
 #include <scene/3d/mesh_instance_3d.h>
+#include <scene/3d/multimesh_instance_3d.h>
 #include <scene/3d/physics/collision_shape_3d.h>
 #include <scene/3d/physics/physics_body_3d.h>
 #include <scene/3d/physics/static_body_3d.h>
@@ -15,8 +17,10 @@
 #include <scene/animation/animation_player.h>
 #include <scene/resources/audio_stream_wav.h>
 #include <scene/resources/mesh_data_tool.h>
+#include <scene/resources/multimesh.h>
 #include <scene/resources/3d/box_shape_3d.h>
 #include <scene/resources/3d/concave_polygon_shape_3d.h>
+#include <scene/resources/3d/height_map_shape_3d.h>
 #include <scene/resources/3d/primitive_meshes.h>
 #include <scene/resources/surface_tool.h>
 #include <scene/resources/image_texture.h>
@@ -27,9 +31,16 @@
 #include <core/crypto/crypto_core.h>
 #include <core/crypto/hashing_context.h>
 #include <core/io/config_file.h>
+#include <core/templates/hash_set.h>
 #include <core/variant/variant_utility.h>
 
-#define TR_TO_GODOT_SCALE 0.001 * 2.0
+#include "tr_level_collision.hpp"
+#include "tr_room_activation.hpp"
+#include "tr_room_lighting.hpp"
+#include "tr_room_visibility.hpp"
+#include "tr_sound_sources.hpp"
+
+#define TR_TO_GODOT_SCALE (0.001 * 2.0)
 
 const real_t TR_SQUARE_SIZE = 1024.0 * TR_TO_GODOT_SCALE;
 const real_t TR_CLICK_SIZE = TR_SQUARE_SIZE / 4.0;
@@ -915,7 +926,11 @@ Node3D *create_godot_moveable_model(
 	TRLevelFormat p_level_format,
 	bool p_using_auxiliary_animation,
 	bool p_use_unique_names,
-	bool p_use_skinning) {
+	bool p_use_skinning,
+	bool p_use_resource_cache,
+	TRLoadStatistics *p_statistics = nullptr) {
+	TR_SCOPED_TIMER(p_statistics, "moveable_model");
+
 	Node3D *new_type_info = memnew(Node3D);
 	new_type_info->set_name(get_type_info_name(p_type_info_id, p_level_format));
 
@@ -997,12 +1012,37 @@ Node3D *create_godot_moveable_model(
 				camera_target->set_unique_name_in_owner(true);
 			}
 
+			// Share the animation data with any identical moveable built for another level.
+			// On a hit only the skeleton and meshes are built; the animations and state machine are reused.
+			TRResourceCache *resource_cache = p_use_resource_cache ? TRResourceCache::get_singleton() : nullptr;
+			String animation_library_key;
+			String animation_tree_root_key;
+			Ref<AnimationLibrary> cached_animation_library;
+			Ref<AnimationRootNode> cached_animation_tree_root;
+			if (resource_cache) {
+				String moveable_hash = get_tr_moveable_content_hash(
+					p_type_info_id,
+					p_moveable_info,
+					p_types,
+					p_samples,
+					p_level_format,
+					p_using_auxiliary_animation,
+					p_use_unique_names);
+
+				animation_library_key = "animation_library_" + moveable_hash;
+				animation_tree_root_key = "animation_tree_root_" + moveable_hash;
+				cached_animation_library = resource_cache->get_resource(animation_library_key);
+				cached_animation_tree_root = resource_cache->get_resource(animation_tree_root_key);
+			}
+			bool use_cached_animations = cached_animation_library.is_valid() && cached_animation_tree_root.is_valid();
+			int64_t built_animation_count = use_cached_animations ? 0 : p_moveable_info.animations.size();
+
 			AnimationPlayer *animation_player = memnew(AnimationPlayer);
 			new_type_info->add_child(animation_player);
 			animation_player->set_name("AnimationPlayer");
 			animation_player->set_audio_max_polyphony(1);
 
-			AnimationNodeStateMachine *state_machine = memnew(AnimationNodeStateMachine);
+			AnimationNodeStateMachine *state_machine = use_cached_animations ? nullptr : memnew(AnimationNodeStateMachine);
 			AnimationTree *animation_tree = memnew(AnimationTree);
 			animation_tree->set_name("AnimationTree");
 			new_type_info->add_child(animation_tree);
@@ -1023,7 +1063,7 @@ Node3D *create_godot_moveable_model(
 			}
 			NodePath shape_path = animation_root_node->get_path_to(collision_shape);
 
-			Ref<AnimationLibrary> animation_library = memnew(AnimationLibrary);
+			Ref<AnimationLibrary> animation_library = use_cached_animations ? cached_animation_library : Ref<AnimationLibrary>(memnew(AnimationLibrary));
 			Ref<Animation> reset_animation = memnew(Animation);
 			reset_animation->set_name("RESET");
 
@@ -1045,7 +1085,9 @@ Node3D *create_godot_moveable_model(
 			reset_animation->track_insert_key(reset_animation->get_track_count() - 1, 0.0, Vector3(1.0, 1.0, 1.0));
 			reset_animation->track_insert_key(reset_animation->get_track_count() - 1, 1.0, Vector3(1.0, 1.0, 1.0));
 
-			animation_library->add_animation("RESET", reset_animation);
+			if (!use_cached_animations) {
+				animation_library->add_animation("RESET", reset_animation);
+			}
 
 			Vector<Ref<Animation>> godot_animations;
 
@@ -1061,7 +1103,7 @@ Node3D *create_godot_moveable_model(
 			HashMap<uint32_t, Vector<uint32_t>> animation_split_table;
 			HashMap<uint32_t, uint32_t> animation_loop_offset_table;
 
-			for (int64_t anim_idx = 0; anim_idx < p_moveable_info.animations.size(); anim_idx++) {
+			for (int64_t anim_idx = 0; anim_idx < built_animation_count; anim_idx++) {
 				Ref<Animation> godot_animation = memnew(Animation);
 				TRAnimation tr_animation = p_moveable_info.animations.get(anim_idx);
 
@@ -1361,8 +1403,9 @@ Node3D *create_godot_moveable_model(
 			}
 
 			// Add nodes to the state machine.
+			TRScopedTimer state_machine_timer(p_statistics, "state_machine_build");
 			size_t grid_size = size_t(Math::floor(Math::sqrt(real_t(p_moveable_info.animations.size()))));
-			for (int64_t anim_idx = 0; anim_idx < p_moveable_info.animations.size(); anim_idx++) {
+			for (int64_t anim_idx = 0; anim_idx < built_animation_count; anim_idx++) {
 				String animation_name = get_animation_name(p_type_info_id, anim_idx, p_level_format, p_using_auxiliary_animation);
 
 				// If we have a looping variation of the animation, add that.
@@ -1419,7 +1462,7 @@ Node3D *create_godot_moveable_model(
 			}
 
 			// Now wire up the transitions.
-			for (int64_t anim_idx = 0; anim_idx < p_moveable_info.animations.size(); anim_idx++) {
+			for (int64_t anim_idx = 0; anim_idx < built_animation_count; anim_idx++) {
 				TRAnimation tr_animation = p_moveable_info.animations.get(anim_idx);
 
 				int32_t animation_length = tr_animation.frame_end - tr_animation.frame_base;
@@ -1607,7 +1650,12 @@ Node3D *create_godot_moveable_model(
 				}
 			}
 			
-			animation_tree->set_root_animation_node(get_animation_tree_root_node_for_object(p_type_info_id, p_level_format, state_machine));
+			if (use_cached_animations) {
+				animation_tree->set_root_animation_node(cached_animation_tree_root);
+			} else {
+				animation_tree->set_root_animation_node(get_animation_tree_root_node_for_object(p_type_info_id, p_level_format, state_machine));
+			}
+			state_machine_timer.stop();
 
 			animation_player->add_animation_library("", animation_library);
 			animation_player->set_assigned_animation("RESET");
@@ -1618,6 +1666,8 @@ Node3D *create_godot_moveable_model(
 			animation_player->set_root_motion_track(root_motion_path_string);
 			animation_tree->set_root_motion_track(root_motion_path_string);
 
+			TRScopedTimer animation_baking_timer(p_statistics, "animation_baking");
+
 			real_t motion_scale = 1.0;
 
 			Vector<Transform3D> bone_pre_transforms;
@@ -1831,7 +1881,7 @@ Node3D *create_godot_moveable_model(
 
 					const int32_t EXTRA_FRAMES = 1;
 
-					for (int64_t anim_idx = 0; anim_idx < p_moveable_info.animations.size(); anim_idx++) {
+					for (int64_t anim_idx = 0; anim_idx < built_animation_count; anim_idx++) {
 						TRAnimation tr_animation = p_moveable_info.animations.get(anim_idx);
 						Ref<Animation> godot_animation = godot_animations[anim_idx];
 
@@ -2182,8 +2232,12 @@ Node3D *create_godot_moveable_model(
 				}
 			}
 
+			animation_baking_timer.stop();
+
 			// Now create the skinned mesh...
 			if (p_use_skinning) {
+				TR_SCOPED_TIMER(p_statistics, "skinned_mesh_build");
+
 				BitField<Mesh::ArrayFormat> combined_mesh_flags = Mesh::ARRAY_FORMAT_VERTEX
 					| Mesh::ARRAY_FORMAT_BONES
 					| Mesh::ARRAY_FORMAT_WEIGHTS
@@ -2354,6 +2408,11 @@ Node3D *create_godot_moveable_model(
 				skeleton->reset_bone_poses();
 				skeleton->update_gizmos();
 			}
+
+			if (resource_cache && !use_cached_animations) {
+				resource_cache->store_resource(animation_library_key, animation_library);
+				resource_cache->store_resource(animation_tree_root_key, animation_tree->get_root_animation_node());
+			}
 		} else {
 			int32_t offset_mesh_index = p_moveable_info.mesh_index;
 			if (offset_mesh_index < p_meshes.size()) {
@@ -2389,12 +2448,22 @@ Vector<Node3D *> create_godot_nodes_for_moveables(
 	Vector<Ref<ArrayMesh>> p_meshes,
 	Vector<Ref<AudioStream>> p_samples,
 	TRLevelFormat p_level_format,
-	bool p_using_auxiliary_animation) {
+	bool p_using_auxiliary_animation,
+	bool p_use_resource_cache,
+	TRLoadProgress *p_progress = nullptr,
+	TRLoadStatistics *p_statistics = nullptr) {
 	Vector<Node3D *> types;
 
 	for (int32_t type_id = 0; type_id < 4096; type_id++) {
+		if (p_progress) {
+			if (p_progress->is_cancelled()) {
+				break;
+			}
+			p_progress->report(TR_LOAD_PHASE_ANIMATIONS, type_id, 4096 * 2);
+		}
+
 		if (p_type_info_map.has(type_id)) {
-			Node3D *new_node = create_godot_moveable_model(type_id, p_type_info_map[type_id], p_types, p_meshes, p_samples, p_level_format, p_using_auxiliary_animation, false, false);
+			Node3D *new_node = create_godot_moveable_model(type_id, p_type_info_map[type_id], p_types, p_meshes, p_samples, p_level_format, p_using_auxiliary_animation, false, false, p_use_resource_cache, p_statistics);
 			if (new_node) {
 				types.push_back(new_node);
 			}
@@ -2514,23 +2583,276 @@ for (int32_t occluder_idx = 0; occluder_idx < p_room_data.room_triangle_count; o
 	}\
 }\
 
+// With p_palette the albedo texture holds 8-bit palette indices, resolved through a 256x1 palette texture.
+Ref<Shader> generate_shader(bool p_transparent, int32_t p_stencil, bool p_texture_array = false, bool p_mipmaps = false, bool p_palette = false) {
+	Ref<Shader> shader = memnew(Shader);
+	String shader_code = "";
+
+	shader_code = "shader_type spatial;\n";
+	if (p_stencil >= 0) {
+		shader_code += "render_mode blend_mix, depth_draw_always, cull_back, diffuse_burley, specular_schlick_ggx, ambient_light_disabled;\n";
+		shader_code += "stencil_mode read, compare_equal, " + itos(p_stencil) + ";\n\n";
+	} else {
+		shader_code += "render_mode blend_mix, depth_draw_opaque, cull_back, diffuse_burley, specular_schlick_ggx, ambient_light_disabled;\n\n";
+	}
+	String albedo_hints = String(p_palette ? "" : "source_color, ") + (p_mipmaps ? "filter_nearest_mipmap" : "filter_nearest") + ", repeat_disable";
+	if (p_texture_array) {
+		shader_code += "uniform sampler2DArray texture_albedo : " + albedo_hints + ";\n\n";
+		shader_code += "varying flat float texture_layer;\n\n";
+		shader_code += "void vertex() {\n\ttexture_layer = CUSTOM0.x;\n}\n\n";
+	} else {
+		shader_code += "uniform sampler2D texture_albedo : " + albedo_hints + ";\n\n";
+	}
+	if (p_palette) {
+		shader_code += "uniform sampler2D palette_texture : source_color, filter_nearest;\n\n";
+	}
+	shader_code += 
+			"void fragment() {\n\
+			vec2 base_uv = UV;\n";
+	String albedo_lookup = p_texture_array ? "texture(texture_albedo, vec3(base_uv, texture_layer))" : "texture(texture_albedo, base_uv)";
+	if (p_palette) {
+		shader_code += "\t\tfloat palette_index = " + albedo_lookup + ".r;\n";
+		shader_code += "\t\tvec4 albedo_tex = texelFetch(palette_texture, ivec2(int(palette_index * 255.0 + 0.5), 0), 0);\n";
+	} else {
+		shader_code += "\t\tvec4 albedo_tex = " + albedo_lookup + ";\n";
+	}
+	shader_code += 
+			"\t\tALBEDO = vec3(0.0, 0.0, 0.0);\n\
+			float inv_gamma =  1.0 / 2.2;\n\
+			float gamma = 2.2;\n\
+			vec3 color_gamma = pow(albedo_tex.rgb, vec3(inv_gamma, inv_gamma, inv_gamma));\n\
+			color_gamma *= COLOR.rgb;\n\
+			color_gamma *= 2.0;\n\
+			EMISSION.rgb = pow(color_gamma, vec3(gamma, gamma, gamma));\n\
+			METALLIC = 0.0;\n\
+			SPECULAR = 1.0;\n\
+			ROUGHNESS = 1.0;\n";
+	if (p_transparent) {
+		shader_code += 
+			"\t\tALPHA = albedo_tex.a;\n";
+		if (p_stencil < 0) {
+			shader_code +=
+				"\t\tALPHA_SCISSOR_THRESHOLD = 1.0;\n";
+		}
+	} else {
+		if (p_stencil >= 0) {
+			shader_code +=
+				"\t\tALPHA = 1.0;\n";
+		}
+	}
+	shader_code += "}";
+
+	shader->set_code(shader_code);
+
+	return shader;
+}
+
+Ref<Material> generate_tr_godot_shader_material(Ref<Texture> p_texture, Ref<Shader> p_shader) {
+	Ref<ShaderMaterial> new_material = memnew(ShaderMaterial);
+
+	new_material->set_shader(p_shader);
+	new_material->set_shader_parameter("texture_albedo", p_texture);
+
+	return new_material;
+}
+
+// Shader counterpart of generate_tr_godot_generic_material for entity meshes,
+// for palette index pages and for the room light list lighting mode. With the
+// light list, lighting is computed per vertex from instance uniforms written
+// by TRRoomLighting instead of by the renderer's lights.
+Ref<Shader> generate_entity_shader(bool p_transparent, bool p_palette, bool p_light_list, bool p_mipmaps = false) {
+	Ref<Shader> shader = memnew(Shader);
+
+	String shader_code = "shader_type spatial;\n";
+	if (p_light_list) {
+		shader_code += "render_mode blend_mix, depth_draw_opaque, cull_back, unshaded;\n\n";
+	} else {
+		shader_code += "render_mode blend_mix, depth_draw_opaque, cull_back, diffuse_lambert_wrap, specular_disabled, vertex_lighting;\n\n";
+	}
+	String albedo_hints = String(p_palette ? "" : "source_color, ") + (p_mipmaps ? "filter_nearest_mipmap" : "filter_nearest") + ", repeat_disable";
+	shader_code += "uniform sampler2D texture_albedo : " + albedo_hints + ";\n";
+	if (p_palette) {
+		shader_code += "uniform sampler2D palette_texture : source_color, filter_nearest;\n";
+	}
+	shader_code += "\n";
+
+	if (p_light_list) {
+		// Instance uniforms can't be arrays, so each light slot is its own pair.
+		shader_code += "instance uniform vec4 tr_ambient_light : source_color = vec4(1.0);\n";
+		for (int32_t light_idx = 0; light_idx < TR_ROOM_LIGHT_LIST_SIZE; light_idx++) {
+			shader_code += "instance uniform vec4 tr_light_position_" + itos(light_idx) + "; // xyz: world position, w: range\n";
+			shader_code += "instance uniform vec4 tr_light_color_" + itos(light_idx) + " : source_color;\n";
+		}
+		shader_code += "\nvarying vec3 tr_light;\n\n";
+		shader_code += "vec3 tr_room_light(vec4 p_position, vec4 p_color, vec3 p_vertex, vec3 p_normal) {\n";
+		shader_code += "\tvec3 to_light = p_position.xyz - p_vertex;\n";
+		shader_code += "\tfloat distance = length(to_light);\n";
+		shader_code += "\tif (p_position.w <= 0.0 || distance >= p_position.w) {\n";
+		shader_code += "\t\treturn vec3(0.0);\n";
+		shader_code += "\t}\n";
+		shader_code += "\treturn p_color.rgb * (1.0 - distance / p_position.w) * max(dot(p_normal, to_light / max(distance, 0.0001)), 0.0);\n";
+		shader_code += "}\n\n";
+		shader_code += "void vertex() {\n";
+		shader_code += "\tvec3 world_vertex = (MODEL_MATRIX * vec4(VERTEX, 1.0)).xyz;\n";
+		shader_code += "\tvec3 world_normal = normalize(mat3(MODEL_MATRIX) * NORMAL);\n";
+		shader_code += "\ttr_light = tr_ambient_light.rgb;\n";
+		for (int32_t light_idx = 0; light_idx < TR_ROOM_LIGHT_LIST_SIZE; light_idx++) {
+			shader_code += "\ttr_light += tr_room_light(tr_light_position_" + itos(light_idx) + ", tr_light_color_" + itos(light_idx) + ", world_vertex, world_normal);\n";
+		}
+		shader_code += "}\n\n";
+	}
+
+	shader_code += "void fragment() {\n";
+	if (p_palette) {
+		shader_code += "\tfloat palette_index = texture(texture_albedo, UV).r;\n";
+		shader_code += "\tvec4 albedo_tex = texelFetch(palette_texture, ivec2(int(palette_index * 255.0 + 0.5), 0), 0);\n";
+	} else {
+		shader_code += "\tvec4 albedo_tex = texture(texture_albedo, UV);\n";
+	}
+	shader_code += String("\tALBEDO = albedo_tex.rgb * COLOR.rgb") + (p_light_list ? " * tr_light" : "") + ";\n";
+	shader_code += "\tMETALLIC = 0.0;\n";
+	shader_code += "\tROUGHNESS = 1.0;\n";
+	if (p_transparent) {
+		shader_code += "\tALPHA = albedo_tex.a;\n";
+		shader_code += "\tALPHA_SCISSOR_THRESHOLD = 0.5;\n";
+	}
+	shader_code += "}\n";
+
+	shader->set_code(shader_code);
+
+	return shader;
+}
+
+enum TRTextureBinding {
+	TR_TEXTURE_BINDING_PAGE, // One texture page per material.
+	TR_TEXTURE_BINDING_ARRAY, // Every page in one Texture2DArray, the layer chosen per vertex.
+};
+
+// Room shaders and materials keyed by (transparency, stencil reference, texture binding).
+// Each shader variant is compiled once and shared by every material of that variant.
+// Samplers can't be instance uniforms, so page materials still differ by their texture
+// parameter, but they are only created the first time a room uses them.
+class TRRoomMaterialCache {
+	HashMap<uint32_t, Ref<Shader>> shaders;
+	HashMap<uint64_t, Ref<Material>> materials;
+
+	Vector<Ref<Texture>> page_textures;
+	Ref<Texture> array_texture;
+	// Set when the page textures hold palette indices.
+	Ref<Texture> palette_texture;
+	bool mipmaps = false;
+
+	static uint32_t get_variant_key(bool p_transparent, int32_t p_stencil, TRTextureBinding p_binding) {
+		return uint32_t(p_transparent) | (uint32_t(p_binding) << 1) | (uint32_t(p_stencil + 1) << 2);
+	}
+
+	Ref<Material> get_material(uint64_t p_key, Ref<Texture> p_texture, bool p_transparent, int32_t p_stencil, TRTextureBinding p_binding) {
+		if (HashMap<uint64_t, Ref<Material>>::Iterator E = materials.find(p_key)) {
+			return E->value;
+		}
+
+		Ref<ShaderMaterial> material = generate_tr_godot_shader_material(p_texture, get_shader(p_transparent, p_stencil, p_binding));
+		if (palette_texture.is_valid()) {
+			material->set_shader_parameter("palette_texture", palette_texture);
+		}
+		materials.insert(p_key, material);
+		return material;
+	}
+
+public:
+	void set_page_textures(const Vector<Ref<Texture>> &p_page_textures) { page_textures = p_page_textures; }
+	int32_t get_page_count() const { return page_textures.size(); }
+
+	void set_array_texture(Ref<Texture> p_array_texture) { array_texture = p_array_texture; }
+	bool has_array_texture() const { return array_texture.is_valid(); }
+
+	void set_palette_texture(Ref<Texture> p_palette_texture) { palette_texture = p_palette_texture; }
+
+	void set_mipmaps(bool p_mipmaps) { mipmaps = p_mipmaps; }
+
+	Ref<Shader> get_shader(bool p_transparent, int32_t p_stencil, TRTextureBinding p_binding) {
+		uint32_t key = get_variant_key(p_transparent, p_stencil, p_binding);
+		if (HashMap<uint32_t, Ref<Shader>>::Iterator E = shaders.find(key)) {
+			return E->value;
+		}
+
+		Ref<Shader> shader = generate_shader(p_transparent, p_stencil, p_binding == TR_TEXTURE_BINDING_ARRAY, mipmaps, palette_texture.is_valid());
+		shaders.insert(key, shader);
+		return shader;
+	}
+
+	Ref<Material> get_page_material(int32_t p_page, bool p_transparent, int32_t p_stencil) {
+		ERR_FAIL_INDEX_V(p_page, page_textures.size(), Ref<Material>());
+		uint64_t key = (uint64_t(p_page) << 32) | get_variant_key(p_transparent, p_stencil, TR_TEXTURE_BINDING_PAGE);
+		return get_material(key, page_textures[p_page], p_transparent, p_stencil, TR_TEXTURE_BINDING_PAGE);
+	}
+
+	Ref<Material> get_array_material(bool p_transparent, int32_t p_stencil) {
+		ERR_FAIL_COND_V(array_texture.is_null(), Ref<Material>());
+		uint64_t key = get_variant_key(p_transparent, p_stencil, TR_TEXTURE_BINDING_ARRAY);
+		return get_material(key, array_texture, p_transparent, p_stencil, TR_TEXTURE_BINDING_ARRAY);
+	}
+
+	int32_t get_shader_count() const { return shaders.size(); }
+	int32_t get_material_count() const { return materials.size(); }
+};
+
 struct TRGodotMaterials {
-	Vector<Ref<Material>> level_solid_materials;
-	Vector<Ref<Material>> level_transparent_materials;
 	Vector<Ref<Material>> entity_solid_materials;
 	Vector<Ref<Material>> entity_transparent_materials;
+};
 
+struct TRTextureInfoRemap {
+	int32_t remap_index = -1;
+	Vector2 uv[4];
 };
 
 struct TRGodotMaterialTable {
 	TRGodotMaterials materials;
-	HashMap<int32_t, TRGodotMaterials> read_stencil_materials;
+	TRRoomMaterialCache room_materials;
+	// Layers whose rooms are seen through a portal of another layer, and so
+	// only draw where that portal wrote its stencil reference.
+	HashSet<int32_t> read_stencil_layers;
 	HashMap<int32_t, Ref<Material>> portal_stencil_materials;
+
+	// Indexed by texture info id when the level textures were repacked into atlases.
+	Vector<TRTextureInfoRemap> texture_info_remaps;
 };
 
+// Points a face's texture info at its atlas page. Since atlas UVs don't fit the
+// 8.8 fixed point TRUV, the corners instead carry (texture info id, corner index),
+// which keeps vertex deduplication exact and is resolved by tr_uv_to_godot_uv.
+static bool remap_tr_face_texture_info(TRTextureInfo &r_texture_info, uint16_t p_tex_info_id, const Vector<TRTextureInfoRemap> &p_texture_info_remaps) {
+	if (p_texture_info_remaps.is_empty()) {
+		return true;
+	}
+
+	ERR_FAIL_INDEX_V(p_tex_info_id, p_texture_info_remaps.size(), false);
+	const TRTextureInfoRemap &remap = p_texture_info_remaps[p_tex_info_id];
+	if (remap.remap_index < 0) {
+		return false;
+	}
+
+	r_texture_info.texture_page = remap.remap_index;
+	for (int32_t j = 0; j < 4; j++) {
+		r_texture_info.uv[j].u = p_tex_info_id;
+		r_texture_info.uv[j].v = j;
+	}
+
+	return true;
+}
+
+static Vector2 tr_uv_to_godot_uv(const TRUV &p_uv, const Vector<TRTextureInfoRemap> &p_texture_info_remaps) {
+	if (!p_texture_info_remaps.is_empty()) {
+		return p_texture_info_remaps[p_uv.u].uv[p_uv.v];
+	}
+
+	return Vector2(u_fixed_16_to_float(p_uv.u, false) / 255.0f, u_fixed_16_to_float(p_uv.v, false) / 255.0f);
+}
+
 Ref<ArrayMesh> tr_room_data_to_godot_mesh(
 	const TRRoomData &p_room_data,
-	const TRGodotMaterialTable &p_material_table,
+	TRGodotMaterialTable &p_material_table,
 	const TRTypes& p_types,
 	const Vector3 p_offset,
 	const Vector<TRRoomPortal> p_visible_from_portals,
@@ -2695,9 +3017,13 @@ Ref<ArrayMesh> tr_room_data_to_godot_mesh(
 		}
 
 		TRTextureInfo texture_info = p_types.texture_infos.get(p_room_data.room_quads[i].tex_info_id);
+		if (!remap_tr_face_texture_info(texture_info, p_room_data.room_quads[i].tex_info_id, p_material_table.texture_info_remaps)) {
+			continue;
+		}
+
 		int32_t material_id = texture_info.texture_page;
 		if (texture_info.draw_type == 1) {
-			material_id += p_material_table.materials.level_solid_materials.size();
+			material_id += p_material_table.room_materials.get_page_count();
 		}
 		last_material_id = material_id > last_material_id ? material_id : last_material_id;
 
@@ -2728,9 +3054,13 @@ Ref<ArrayMesh> tr_room_data_to_godot_mesh(
 		}
 
 		TRTextureInfo texture_info = p_types.texture_infos.get(p_room_data.room_triangles[i].tex_info_id);
+		if (!remap_tr_face_texture_info(texture_info, p_room_data.room_triangles[i].tex_info_id, p_material_table.texture_info_remaps)) {
+			continue;
+		}
+
 		int32_t material_id = texture_info.texture_page;
 		if (texture_info.draw_type == 1) {
-			material_id += p_material_table.materials.level_solid_materials.size();
+			material_id += p_material_table.room_materials.get_page_count();
 		}
 
 		last_material_id = material_id > last_material_id ? material_id : last_material_id;
@@ -2748,16 +3078,57 @@ Ref<ArrayMesh> tr_room_data_to_godot_mesh(
 		INSERT_TEXTURED_VERTEX(p_room_data.room_triangles[i].indices[2], texture_info.uv[2], material_id, vertex_uv_map, material_index_map, room_verts);
 	}
 
-	Vector<Ref<Material>> all_materials;
-	if (p_material_table.read_stencil_materials.has(stencil_id)) {
-		all_materials = p_material_table.read_stencil_materials.get(stencil_id).level_solid_materials;
-		all_materials.append_array(p_material_table.read_stencil_materials.get(stencil_id).level_transparent_materials);
-	} else {
-		all_materials = p_material_table.materials.level_solid_materials;
-		all_materials.append_array(p_material_table.materials.level_transparent_materials);
+	TRRoomMaterialCache &room_materials = p_material_table.room_materials;
+	int32_t material_stencil = p_material_table.read_stencil_layers.has(stencil_id) ? stencil_id : -1;
+
+	// With a texture array the per-page buckets are merged into one solid and
+	// one transparent surface, and the page becomes a per-vertex array layer.
+	bool use_texture_array = room_materials.has_array_texture();
+	int32_t page_count = room_materials.get_page_count();
+
+	for (int32_t surface_idx = 0; use_texture_array && surface_idx < 2; surface_idx++) {
+		st->begin(Mesh::PRIMITIVE_TRIANGLES);
+		st->set_custom_format(0, SurfaceTool::CUSTOM_R_FLOAT);
+
+		int32_t index_offset = 0;
+		for (int32_t texture_page = 0; texture_page < page_count; texture_page++) {
+			int32_t material_id = texture_page + (surface_idx * page_count);
+			if (!vertex_uv_map.has(material_id) || !material_index_map.has(material_id)) {
+				continue;
+			}
+
+			const Vector<VertexAndUV> &vertices_and_uvs = vertex_uv_map.get(material_id);
+			for (const VertexAndUV &vertex_and_uv : vertices_and_uvs) {
+				TRRoomVertex room_vertex = room_verts[vertex_and_uv.vertex_idx];
+
+				st->set_color(room_vertex.color);
+				st->set_uv(tr_uv_to_godot_uv(vertex_and_uv.uv, p_material_table.texture_info_remaps));
+				st->set_custom(0, Color(real_t(texture_page), 0.0, 0.0, 0.0));
+
+				Vector3 vec3 = Vector3(
+					room_vertex.vertex.x * TR_TO_GODOT_SCALE,
+					room_vertex.vertex.y * -TR_TO_GODOT_SCALE,
+					room_vertex.vertex.z * -TR_TO_GODOT_SCALE) + p_offset;
+
+				st->add_vertex(vec3);
+			}
+
+			for (const int32_t &index : material_index_map.get(material_id)) {
+				st->add_index(index_offset + index);
+			}
+			index_offset += vertices_and_uvs.size();
+		}
+
+		if (index_offset == 0) {
+			continue;
+		}
+
+		st->set_material(room_materials.get_array_material(surface_idx == 1, material_stencil));
+		st->generate_normals();
+		ar_mesh = st->commit(ar_mesh);
 	}
 
-	for (int64_t current_tex_page = 0; current_tex_page < last_material_id + 1; current_tex_page++) {
+	for (int64_t current_tex_page = 0; !use_texture_array && current_tex_page < last_material_id + 1; current_tex_page++) {
 
 		st->begin(Mesh::PRIMITIVE_TRIANGLES);
 
@@ -2771,7 +3142,7 @@ Ref<ArrayMesh> tr_room_data_to_godot_mesh(
 
 			st->set_color(room_vertex.color);
 
-			Vector2 uv = Vector2(u_fixed_16_to_float(vertex_and_uv.uv.u, false) / 255.0f, u_fixed_16_to_float(vertex_and_uv.uv.v, false) / 255.0f);
+			Vector2 uv = tr_uv_to_godot_uv(vertex_and_uv.uv, p_material_table.texture_info_remaps);
 			st->set_uv(uv);
 
 			Vector3 vec3 = Vector3(
@@ -2786,8 +3157,8 @@ Ref<ArrayMesh> tr_room_data_to_godot_mesh(
 			st->add_index(material_index_map.get(current_tex_page).get(i));
 		}
 
-		if (all_materials.size() > current_tex_page) {
-			st->set_material(all_materials.get(current_tex_page));
+		if (current_tex_page < page_count * 2) {
+			st->set_material(room_materials.get_page_material(current_tex_page % page_count, current_tex_page >= page_count, material_stencil));
 		}
 		st->generate_normals();
 		ar_mesh = st->commit(ar_mesh);
@@ -2844,7 +3215,8 @@ Ref<ArrayMesh> tr_mesh_to_godot_mesh(
 	const Vector<Ref<Material>> p_solid_materials,
 	const Vector<Ref<Material>> p_level_materials,
 	const Ref<Material> p_level_palette_material,
-	const Vector<TRTextureInfo> p_texture_infos) {
+	const Vector<TRTextureInfo> p_texture_infos,
+	const Vector<TRTextureInfoRemap> &p_texture_info_remaps = Vector<TRTextureInfoRemap>()) {
 	Ref<SurfaceTool> st = memnew(SurfaceTool);
 	Ref<ArrayMesh> ar_mesh = memnew(ArrayMesh);
 
@@ -2931,6 +3303,10 @@ Ref<ArrayMesh> tr_mesh_to_godot_mesh(
 	for (int32_t i = 0; i < p_mesh_data.texture_quads_count; i++) {
 		if (i < p_mesh_data.texture_quads.size()) { // Cape Fear bug
 			TRTextureInfo texture_info = p_texture_infos.get(p_mesh_data.texture_quads[i].tex_info_id);
+			if (!remap_tr_face_texture_info(texture_info, p_mesh_data.texture_quads[i].tex_info_id, p_texture_info_remaps)) {
+				continue;
+			}
+
 			int32_t material_id = texture_info.texture_page;
 			if (texture_info.draw_type == 1) {
 				material_id += p_solid_materials.size();
@@ -2958,6 +3334,10 @@ Ref<ArrayMesh> tr_mesh_to_godot_mesh(
 	for (int32_t i = 0; i < p_mesh_data.texture_triangles_count; i++) {
 		if (i < p_mesh_data.texture_triangles.size()) { // Cape Fear bug
 			TRTextureInfo texture_info = p_texture_infos.get(p_mesh_data.texture_triangles[i].tex_info_id);
+			if (!remap_tr_face_texture_info(texture_info, p_mesh_data.texture_triangles[i].tex_info_id, p_texture_info_remaps)) {
+				continue;
+			}
+
 			int32_t material_id = texture_info.texture_page;
 			if (texture_info.draw_type == 1) {
 				material_id += p_solid_materials.size();
@@ -3031,7 +3411,7 @@ Ref<ArrayMesh> tr_mesh_to_godot_mesh(
 			VertexAndUV vertex_and_uv = vertex_uv_map.get(current_tex_page).get(i);
 			TRVertex vertex = mesh_verts[vertex_and_uv.vertex_idx];
 
-			Vector2 uv = Vector2(u_fixed_16_to_float(vertex_and_uv.uv.u, false) / 255.0f, u_fixed_16_to_float(vertex_and_uv.uv.v, false) / 255.0f);
+			Vector2 uv = tr_uv_to_godot_uv(vertex_and_uv.uv, p_texture_info_remaps);
 			st->set_uv(uv);
 
 			if (vertex_and_uv.vertex_idx < mesh_normals.size()) {
@@ -3559,106 +3939,1212 @@ CollisionShape3D *tr_room_to_godot_collision_shape(
 	return sbar;
 }
 
+struct TRCollisionCell {
+	int32_t triangle_count = 0;
+	int32_t triangles[2] = { -1, -1 };
+	real_t corner_heights[2][2] = {};
+	bool corner_set[2][2] = {};
+	bool eligible = false;
+	bool covered = false;
+};
 
-Ref<Material> generate_tr_godot_generic_material(Ref<ImageTexture> p_image_texture, bool p_is_transparent) {
-	Ref<StandardMaterial3D> new_material = memnew(StandardMaterial3D);
+// Collects the whole-sector floor or ceiling quads of a room's trimesh. A cell
+// can become part of a heightmap when its two triangles cover the sector and
+// its corners are coplanar, so the heightmap's own diagonal doesn't matter.
+static void collect_tr_collision_cells(const PackedVector3Array &p_faces, bool p_ceiling, const Vector3 &p_offset, int32_t p_columns, int32_t p_rows, const LocalVector<bool> &p_solid, LocalVector<TRCollisionCell> &r_cells) {
+	const real_t epsilon = 0.001;
 
-	new_material->set_diffuse_mode(BaseMaterial3D::DIFFUSE_LAMBERT_WRAP);
-	new_material->set_shading_mode(BaseMaterial3D::SHADING_MODE_PER_VERTEX);
-	new_material->set_specular(0.0);
-	new_material->set_roughness(1.0);
-	new_material->set_metallic(0.0);
-	new_material->set_flag(BaseMaterial3D::FLAG_ALBEDO_FROM_VERTEX_COLOR, true);
-	new_material->set_texture(BaseMaterial3D::TEXTURE_ALBEDO, p_image_texture);
-	new_material->set_texture_filter(BaseMaterial3D::TEXTURE_FILTER_NEAREST);
-	new_material->set_flag(BaseMaterial3D::Flags::FLAG_USE_TEXTURE_REPEAT, false);
-	if (p_is_transparent) {
-		new_material->set_transparency(BaseMaterial3D::TRANSPARENCY_ALPHA_SCISSOR);
+	r_cells.resize(p_columns * p_rows);
+	for (TRCollisionCell &cell : r_cells) {
+		cell = TRCollisionCell();
 	}
 
-	return new_material;
-}
+	for (int32_t triangle_idx = 0; triangle_idx < p_faces.size() / 3; triangle_idx++) {
+		const Vector3 *vertices = &p_faces[triangle_idx * 3];
+		Vector3 normal = (vertices[1] - vertices[0]).cross(vertices[2] - vertices[0]);
+		// Floors wind with a downward normal and ceilings with an upward one.
+		if (Math::abs(normal.y) <= epsilon || (normal.y > 0.0) != p_ceiling) {
+			continue;
+		}
 
-Ref<Material> generate_tr_godot_shader_material(Ref<ImageTexture> p_image_texture, Ref<Shader> p_shader) {
-	Ref<ShaderMaterial> new_material = memnew(ShaderMaterial);
+		Vector3 centroid = (vertices[0] + vertices[1] + vertices[2]) / 3.0;
+		int32_t column = int32_t(Math::floor((centroid.x - p_offset.x) / TR_SQUARE_SIZE));
+		int32_t row = int32_t(Math::floor((p_offset.z - centroid.z) / TR_SQUARE_SIZE));
+		if (column < 0 || column >= p_columns || row < 0 || row >= p_rows) {
+			continue;
+		}
 
-	new_material->set_shader(p_shader);
-	new_material->set_shader_parameter("texture_albedo", p_image_texture);
+		TRCollisionCell &cell = r_cells[column * p_rows + row];
+		if (cell.triangle_count >= 2) {
+			cell.triangle_count++;
+			continue;
+		}
+		cell.triangles[cell.triangle_count++] = triangle_idx;
+
+		for (int32_t vertex_idx = 0; vertex_idx < 3; vertex_idx++) {
+			real_t corner_x = (vertices[vertex_idx].x - p_offset.x) / TR_SQUARE_SIZE - column;
+			real_t corner_z = (p_offset.z - vertices[vertex_idx].z) / TR_SQUARE_SIZE - row;
+			int32_t dx = int32_t(Math::round(corner_x));
+			int32_t dz = int32_t(Math::round(corner_z));
+			if (Math::abs(corner_x - dx) > epsilon || Math::abs(corner_z - dz) > epsilon || dx < 0 || dx > 1 || dz < 0 || dz > 1) {
+				cell.triangle_count = 3;
+				break;
+			}
+			if (cell.corner_set[dx][dz] && Math::abs(cell.corner_heights[dx][dz] - vertices[vertex_idx].y) > epsilon) {
+				cell.triangle_count = 3;
+				break;
+			}
+			cell.corner_heights[dx][dz] = vertices[vertex_idx].y;
+			cell.corner_set[dx][dz] = true;
+		}
+	}
 
-	return new_material;
+	for (int32_t cell_idx = 0; cell_idx < int32_t(r_cells.size()); cell_idx++) {
+		TRCollisionCell &cell = r_cells[cell_idx];
+		cell.eligible = !p_solid[cell_idx] && cell.triangle_count == 2 &&
+				cell.corner_set[0][0] && cell.corner_set[0][1] && cell.corner_set[1][0] && cell.corner_set[1][1] &&
+				Math::abs((cell.corner_heights[0][0] + cell.corner_heights[1][1]) - (cell.corner_heights[1][0] + cell.corner_heights[0][1])) <= epsilon;
+	}
 }
 
+static bool tr_collision_cells_share_column_edge(const TRCollisionCell &p_left, const TRCollisionCell &p_right) {
+	return Math::is_equal_approx(p_left.corner_heights[1][0], p_right.corner_heights[0][0]) &&
+			Math::is_equal_approx(p_left.corner_heights[1][1], p_right.corner_heights[0][1]);
+}
 
-void set_owner_recursively(Node *p_node, Node *p_owner) {
-	p_node->set_owner(p_owner);
-	for (int32_t i = 0; i < p_node->get_child_count(); i++) {
-		set_owner_recursively(p_node->get_child(i), p_owner);
-	}
+static bool tr_collision_cells_share_row_edge(const TRCollisionCell &p_near, const TRCollisionCell &p_far) {
+	return Math::is_equal_approx(p_near.corner_heights[0][1], p_far.corner_heights[0][0]) &&
+			Math::is_equal_approx(p_near.corner_heights[1][1], p_far.corner_heights[1][0]);
 }
 
-void add_pixel_padding(Ref<Image> p_target_image, Ref<Image> p_source_image, Rect2i p_source_rect, Point2i p_target_position, int32_t p_pixel_padding) {
-	for (int32_t i = 0; i < p_pixel_padding / 2; i++) {
-		// Top
-		for (int32_t x = 0 - (i + 1); x < p_source_rect.size.width + (i + 1); x++) {
-			p_target_image->set_pixel(p_target_position.x + x, p_target_position.y - (i + 1), p_source_image->get_pixel(CLAMP(x, 0, p_source_image->get_width() - 1), 0));
-		}
+// Greedily grows rectangles of eligible cells whose shared edges line up and
+// turns each into a HeightMapShape3D. Ceilings are flipped so they collide
+// from below.
+static void build_tr_collision_heightmaps(LocalVector<TRCollisionCell> &r_cells, bool p_ceiling, const Vector3 &p_offset, int32_t p_columns, int32_t p_rows, Vector<CollisionShape3D *> &r_shapes) {
+	for (int32_t start_column = 0; start_column < p_columns; start_column++) {
+		for (int32_t start_row = 0; start_row < p_rows; start_row++) {
+			if (!r_cells[start_column * p_rows + start_row].eligible || r_cells[start_column * p_rows + start_row].covered) {
+				continue;
+			}
 
-		// Bottom
-		for (int32_t x = 0 - (i + 1); x < p_source_rect.size.width + (i + 1); x++) {
-			p_target_image->set_pixel(p_target_position.x + x, p_target_position.y + p_source_rect.get_size().y + (i), p_source_image->get_pixel(CLAMP(x, 0, p_source_image->get_width() - 1), p_source_rect.get_size().y - 1));
-		}
+			int32_t end_row = start_row + 1;
+			while (end_row < p_rows) {
+				const TRCollisionCell &cell = r_cells[start_column * p_rows + end_row];
+				if (!cell.eligible || cell.covered || !tr_collision_cells_share_row_edge(r_cells[start_column * p_rows + end_row - 1], cell)) {
+					break;
+				}
+				end_row++;
+			}
 
-		// Left
-		for (int32_t y = 0 - (i + 1); y < p_source_rect.size.height + (i + 1); y++) {
-			p_target_image->set_pixel(p_target_position.x - (i + 1), p_target_position.y + y, p_source_image->get_pixel(0, CLAMP(y, 0, p_source_image->get_height() - 1)));
-		}
+			int32_t end_column = start_column + 1;
+			while (end_column < p_columns) {
+				bool column_fits = true;
+				for (int32_t row = start_row; row < end_row && column_fits; row++) {
+					const TRCollisionCell &cell = r_cells[end_column * p_rows + row];
+					column_fits = cell.eligible && !cell.covered &&
+							tr_collision_cells_share_column_edge(r_cells[(end_column - 1) * p_rows + row], cell) &&
+							(row == start_row || tr_collision_cells_share_row_edge(r_cells[end_column * p_rows + row - 1], cell));
+				}
+				if (!column_fits) {
+					break;
+				}
+				end_column++;
+			}
+
+			int32_t width = end_column - start_column;
+			int32_t depth = end_row - start_row;
+
+			// Heightmap vertices are one unit apart around the origin, so the
+			// shape is scaled up to sector size and the heights down by as much.
+			PackedFloat32Array heights;
+			heights.resize((width + 1) * (depth + 1));
+			for (int32_t z = 0; z <= depth; z++) {
+				int32_t row_line = start_row + (p_ceiling ? z : depth - z);
+				for (int32_t x = 0; x <= width; x++) {
+					int32_t column_line = start_column + x;
+					int32_t column = MIN(column_line, end_column - 1);
+					int32_t row = MIN(row_line, end_row - 1);
+					real_t height = r_cells[column * p_rows + row].corner_heights[column_line - column][row_line - row];
+					heights.set(z * (width + 1) + x, (p_ceiling ? -height : height) / TR_SQUARE_SIZE);
+				}
+			}
+
+			for (int32_t column = start_column; column < end_column; column++) {
+				for (int32_t row = start_row; row < end_row; row++) {
+					r_cells[column * p_rows + row].covered = true;
+				}
+			}
+
+			Ref<HeightMapShape3D> heightmap = memnew(HeightMapShape3D);
+			heightmap->set_map_width(width + 1);
+			heightmap->set_map_depth(depth + 1);
+			heightmap->set_map_data(heights);
+
+			Basis basis = Basis().scaled(Vector3(TR_SQUARE_SIZE, TR_SQUARE_SIZE, TR_SQUARE_SIZE));
+			if (p_ceiling) {
+				basis = Basis(Vector3(1.0, 0.0, 0.0), Math::PI) * basis;
+			}
 
-		// Right
-		for (int32_t y = 0 - (i + 1); y < p_source_rect.size.height + (i + 1); y++) {
-			p_target_image->set_pixel(p_target_position.x + p_source_rect.get_size().x + (i), p_target_position.y + y, p_source_image->get_pixel(p_source_rect.get_size().x - 1, CLAMP(y, 0, p_source_image->get_height() - 1)));
+			CollisionShape3D *collision_shape = memnew(CollisionShape3D);
+			collision_shape->set_shape(heightmap);
+			collision_shape->set_name(String(p_ceiling ? "CeilingHeightMap_" : "FloorHeightMap_") + itos(r_shapes.size()));
+			collision_shape->set_transform(Transform3D(basis, Vector3(
+				p_offset.x + (start_column + width * 0.5) * TR_SQUARE_SIZE,
+				0.0,
+				p_offset.z - (start_row + depth * 0.5) * TR_SQUARE_SIZE)));
+			r_shapes.push_back(collision_shape);
 		}
 	}
 }
 
-uint32_t get_hash_for_image(Ref<Image> p_image) {
-	Array image_array;
-	image_array.append(p_image->get_width());
-	image_array.append(p_image->get_height());
-	image_array.append(p_image->get_format());
-	image_array.append(p_image->get_data());
-
-	return image_array.hash();
-}
+// Collision built around the 1024 unit sector grid instead of one concave
+// trimesh: whole-sector floors and ceilings become heightmaps, solid sectors
+// become merged boxes spanning the room's height, and only the remaining
+// irregular faces stay in a ConcavePolygonShape3D.
+Vector<CollisionShape3D *> tr_room_to_godot_grid_collision_shapes(
+	const TRRoom& p_current_room,
+	const PackedByteArray p_floor_data,
+	const Vector<TRRoom> p_rooms,
+	const Vector3 p_offset) {
+	Vector<CollisionShape3D *> shapes;
 
-struct TRTextureInfoRemapInfoChart {
-	Point2i src_points[4];
-	uint32_t src_texture_page_id;
-	uint32_t src_chart_id;
-};
+	CollisionShape3D *trimesh_shape = tr_room_to_godot_collision_shape(p_current_room, p_floor_data, p_rooms, p_offset);
+	Ref<ConcavePolygonShape3D> trimesh = trimesh_shape->get_shape();
+	PackedVector3Array faces = trimesh->get_faces();
 
-struct TRTexturePageAtlas {
-	Vector<Rect2i> used_charts;
-};
+	int32_t columns = p_current_room.sector_count_z;
+	int32_t rows = p_current_room.sector_count_x;
 
-struct TRMoveableReAtlasResult {
-	//HashMap<uint32_t, TRMoveableReAtlasedMeshData> mesh_table;
-	Vector<Ref<Image>> custom_atlases;
-};
+	LocalVector<bool> solid;
+	solid.resize(columns * rows);
+	for (int32_t sector_idx = 0; sector_idx < columns * rows; sector_idx++) {
+		const TRRoomSector &room_sector = p_current_room.sectors[sector_idx];
+		solid[sector_idx] = room_sector.floor == -127 && parse_floor_data_entry(p_floor_data, room_sector.floor_data_index).portal_room == 0xff;
+	}
 
-TRMoveableReAtlasResult reatlas_object_group_textures(
-	const Vector<TRMoveableInfo> p_moveable_infos,
-	const Vector<TRMesh> &p_meshes,
-	const Vector<TRTextureInfo> p_texture_infos,
-	const Vector<Ref<Image>> p_images) {
+	LocalVector<bool> removed_faces;
+	removed_faces.resize(faces.size() / 3);
+	for (bool &removed : removed_faces) {
+		removed = false;
+	}
 
-	// This is a pretty suboptimal texture-atlas creator, but it should hopefully be *good enough* for now.
+	LocalVector<TRCollisionCell> cells;
+	for (int32_t pass = 0; pass < 2; pass++) {
+		bool ceiling = pass == 1;
+		collect_tr_collision_cells(faces, ceiling, p_offset, columns, rows, solid, cells);
+		build_tr_collision_heightmaps(cells, ceiling, p_offset, columns, rows, shapes);
+		for (const TRCollisionCell &cell : cells) {
+			if (cell.covered) {
+				removed_faces[cell.triangles[0]] = true;
+				removed_faces[cell.triangles[1]] = true;
+			}
+		}
+	}
 
-	Vector<TRTextureInfoRemapInfoChart> texture_info_remaps;
+	// Solid sectors, merged into rectangles along rows first.
+	real_t room_height = (p_current_room.info.y_bottom - p_current_room.info.y_top) * TR_TO_GODOT_SCALE;
+	LocalVector<bool> boxed;
+	boxed.resize(columns * rows);
+	for (bool &is_boxed : boxed) {
+		is_boxed = false;
+	}
+	for (int32_t start_column = 0; start_column < columns; start_column++) {
+		for (int32_t start_row = 0; start_row < rows; start_row++) {
+			if (!solid[start_column * rows + start_row] || boxed[start_column * rows + start_row]) {
+				continue;
+			}
+
+			int32_t end_row = start_row + 1;
+			while (end_row < rows && solid[start_column * rows + end_row] && !boxed[start_column * rows + end_row]) {
+				end_row++;
+			}
+
+			int32_t end_column = start_column + 1;
+			while (end_column < columns) {
+				bool column_fits = true;
+				for (int32_t row = start_row; row < end_row && column_fits; row++) {
+					column_fits = solid[end_column * rows + row] && !boxed[end_column * rows + row];
+				}
+				if (!column_fits) {
+					break;
+				}
+				end_column++;
+			}
+
+			for (int32_t column = start_column; column < end_column; column++) {
+				for (int32_t row = start_row; row < end_row; row++) {
+					boxed[column * rows + row] = true;
+				}
+			}
+
+			Ref<BoxShape3D> box = memnew(BoxShape3D);
+			box->set_size(Vector3((end_column - start_column) * TR_SQUARE_SIZE, room_height, (end_row - start_row) * TR_SQUARE_SIZE));
+
+			CollisionShape3D *collision_shape = memnew(CollisionShape3D);
+			collision_shape->set_shape(box);
+			collision_shape->set_name("WallBox_" + itos(shapes.size()));
+			collision_shape->set_position(Vector3(
+				p_offset.x + (start_column + end_column) * 0.5 * TR_SQUARE_SIZE,
+				room_height * 0.5,
+				p_offset.z - (start_row + end_row) * 0.5 * TR_SQUARE_SIZE));
+			shapes.push_back(collision_shape);
+		}
+	}
+
+	// Wall faces lying on an edge of a solid sector are inside its box.
+	const real_t epsilon = 0.001;
+	for (int32_t triangle_idx = 0; triangle_idx < faces.size() / 3; triangle_idx++) {
+		const Vector3 *vertices = &faces[triangle_idx * 3];
+		Vector3 normal = (vertices[1] - vertices[0]).cross(vertices[2] - vertices[0]);
+		if (removed_faces[triangle_idx] || Math::abs(normal.y) > epsilon) {
+			continue;
+		}
+
+		Vector3 centroid = (vertices[0] + vertices[1] + vertices[2]) / 3.0;
+		real_t column_line = (centroid.x - p_offset.x) / TR_SQUARE_SIZE;
+		real_t row_line = (p_offset.z - centroid.z) / TR_SQUARE_SIZE;
+
+		int32_t sides[2] = { -1, -1 };
+		if (Math::abs(normal.z) <= epsilon && Math::abs(column_line - Math::round(column_line)) <= epsilon) {
+			int32_t row = int32_t(Math::floor(row_line));
+			int32_t column = int32_t(Math::round(column_line));
+			if (row >= 0 && row < rows) {
+				sides[0] = column - 1 >= 0 ? (column - 1) * rows + row : -1;
+				sides[1] = column < columns ? column * rows + row : -1;
+			}
+		} else if (Math::abs(normal.x) <= epsilon && Math::abs(row_line - Math::round(row_line)) <= epsilon) {
+			int32_t column = int32_t(Math::floor(column_line));
+			int32_t row = int32_t(Math::round(row_line));
+			if (column >= 0 && column < columns) {
+				sides[0] = row - 1 >= 0 ? column * rows + row - 1 : -1;
+				sides[1] = row < rows ? column * rows + row : -1;
+			}
+		}
+
+		if ((sides[0] >= 0 && solid[sides[0]]) || (sides[1] >= 0 && solid[sides[1]])) {
+			removed_faces[triangle_idx] = true;
+		}
+	}
+
+	PackedVector3Array remaining_faces;
+	for (int32_t triangle_idx = 0; triangle_idx < faces.size() / 3; triangle_idx++) {
+		if (!removed_faces[triangle_idx]) {
+			remaining_faces.push_back(faces[triangle_idx * 3 + 0]);
+			remaining_faces.push_back(faces[triangle_idx * 3 + 1]);
+			remaining_faces.push_back(faces[triangle_idx * 3 + 2]);
+		}
+	}
+
+	if (remaining_faces.is_empty()) {
+		memdelete(trimesh_shape);
+	} else {
+		trimesh->set_faces(remaining_faces);
+		shapes.push_back(trimesh_shape);
+	}
+
+	return shapes;
+}
+
+Transform3D get_tr_room_static_mesh_transform(const TRRoomStaticMesh &p_room_static_mesh) {
+	return Transform3D(Basis().rotated(
+		Vector3(0.0, 1.0, 0.0), Math::deg_to_rad((float)p_room_static_mesh.rotation / 16384.0f * -90)), Vector3(
+			p_room_static_mesh.pos.x * TR_TO_GODOT_SCALE,
+			p_room_static_mesh.pos.y * -TR_TO_GODOT_SCALE,
+			p_room_static_mesh.pos.z * -TR_TO_GODOT_SCALE));
+}
+
+// Appends a static mesh to a room's geometry, so it is drawn with the room's
+// surfaces and materials. The static's shade becomes its vertex lighting, as
+// the room shaders expect. Returns false, leaving the room untouched, for
+// meshes with untextured faces or when the room would overflow 16-bit indices.
+bool append_tr_static_mesh_to_room_data(TRRoomData &r_room_data, const TRMesh &p_mesh, const TRRoomStaticMesh &p_room_static_mesh, const TRRoomInfo &p_room_info) {
+	if (!p_mesh.color_quads.is_empty() || !p_mesh.color_triangles.is_empty()) {
+		return false;
+	}
+
+	int32_t vertex_offset = r_room_data.room_vertices.size();
+	if (vertex_offset + p_mesh.vertices.size() > INT16_MAX ||
+			r_room_data.room_quads.size() + p_mesh.texture_quads.size() > INT16_MAX ||
+			r_room_data.room_triangles.size() + p_mesh.texture_triangles.size() > INT16_MAX) {
+		return false;
+	}
+
+	Transform3D static_mesh_transform = get_tr_room_static_mesh_transform(p_room_static_mesh);
+	for (const TRVertex &vertex : p_mesh.vertices) {
+		Vector3 position = static_mesh_transform.xform(Vector3(vertex.x, -vertex.y, -vertex.z) * TR_TO_GODOT_SCALE) / TR_TO_GODOT_SCALE;
+
+		TRRoomVertex room_vertex;
+		room_vertex.vertex.x = int16_t(Math::round(position.x) - p_room_info.x);
+		room_vertex.vertex.y = int16_t(Math::round(-position.y));
+		room_vertex.vertex.z = int16_t(Math::round(-position.z) - p_room_info.z);
+		room_vertex.color = p_room_static_mesh.color_1;
+		room_vertex.color2 = p_room_static_mesh.color_2;
+		room_vertex.attributes = 0;
+		r_room_data.room_vertices.push_back(room_vertex);
+	}
+
+	for (TRFaceQuad quad : p_mesh.texture_quads) {
+		for (int16_t &index : quad.indices) {
+			index += vertex_offset;
+		}
+		r_room_data.room_quads.push_back(quad);
+	}
+	for (TRFaceTriangle triangle : p_mesh.texture_triangles) {
+		for (int16_t &index : triangle.indices) {
+			index += vertex_offset;
+		}
+		r_room_data.room_triangles.push_back(triangle);
+	}
+
+	r_room_data.room_vertex_count = r_room_data.room_vertices.size();
+	r_room_data.room_quad_count = r_room_data.room_quads.size();
+	r_room_data.room_triangle_count = r_room_data.room_triangles.size();
+
+	return true;
+}
+
+// Instances of one static mesh. The first shade multiplies the vertex colour;
+// the second, used by the alternate lighting modes, is kept in INSTANCE_CUSTOM.
+struct TRStaticMeshBatch {
+	LocalVector<Transform3D> transforms;
+	LocalVector<Color> colors;
+	LocalVector<Color> alternate_colors;
+
+	void add_instance(const Transform3D &p_transform, const TRRoomStaticMesh &p_room_static_mesh) {
+		transforms.push_back(p_transform);
+		colors.push_back(p_room_static_mesh.color_1);
+		alternate_colors.push_back(p_room_static_mesh.color_2);
+	}
+};
+
+MultiMeshInstance3D *create_tr_static_mesh_multimesh_instance(Ref<ArrayMesh> p_mesh, const TRStaticMeshBatch &p_batch) {
+	Ref<MultiMesh> multimesh = memnew(MultiMesh);
+	multimesh->set_transform_format(MultiMesh::TRANSFORM_3D);
+	multimesh->set_use_colors(true);
+	multimesh->set_use_custom_data(true);
+	multimesh->set_mesh(p_mesh);
+	multimesh->set_instance_count(p_batch.transforms.size());
+
+	for (uint32_t instance_idx = 0; instance_idx < p_batch.transforms.size(); instance_idx++) {
+		multimesh->set_instance_transform(instance_idx, p_batch.transforms[instance_idx]);
+		multimesh->set_instance_color(instance_idx, p_batch.colors[instance_idx]);
+		multimesh->set_instance_custom_data(instance_idx, p_batch.alternate_colors[instance_idx]);
+	}
+
+	MultiMeshInstance3D *mmi = memnew(MultiMeshInstance3D);
+	mmi->set_multimesh(multimesh);
+	mmi->set_layer_mask(1 << 0);
+
+	return mmi;
+}
+
+struct TRSceneRenderCounts {
+	int32_t nodes = 0;
+	int32_t mesh_instances = 0;
+	int32_t multimesh_instances = 0;
+	int32_t draw_calls = 0;
+};
+
+// A MultiMesh surface is one draw call however many instances it holds.
+void count_tr_scene_render_nodes(Node *p_node, TRSceneRenderCounts &r_counts) {
+	r_counts.nodes++;
+
+	if (MeshInstance3D *mesh_instance = Object::cast_to<MeshInstance3D>(p_node)) {
+		r_counts.mesh_instances++;
+		if (mesh_instance->get_mesh().is_valid()) {
+			r_counts.draw_calls += mesh_instance->get_mesh()->get_surface_count();
+		}
+	} else if (MultiMeshInstance3D *multimesh_instance = Object::cast_to<MultiMeshInstance3D>(p_node)) {
+		r_counts.multimesh_instances++;
+		if (multimesh_instance->get_multimesh().is_valid() && multimesh_instance->get_multimesh()->get_mesh().is_valid()) {
+			r_counts.draw_calls += multimesh_instance->get_multimesh()->get_mesh()->get_surface_count();
+		}
+	}
+
+	for (int32_t i = 0; i < p_node->get_child_count(); i++) {
+		count_tr_scene_render_nodes(p_node->get_child(i), r_counts);
+	}
+}
+
+Dictionary get_tr_scene_render_statistics(Node *p_root) {
+	TRSceneRenderCounts counts;
+	count_tr_scene_render_nodes(p_root, counts);
+
+	Dictionary statistics;
+	statistics["nodes"] = counts.nodes;
+	statistics["mesh_instances"] = counts.mesh_instances;
+	statistics["multimesh_instances"] = counts.multimesh_instances;
+	statistics["draw_calls"] = counts.draw_calls;
+	return statistics;
+}
+
+// Ambient light and light list of one room, in the form TRRoomLighting reads them.
+Dictionary get_tr_room_lighting_data(const TRRoom &p_room) {
+	Dictionary room_lighting;
+	room_lighting["ambient_light"] = p_room.ambient_light;
+
+	PackedVector3Array light_positions;
+	PackedFloat32Array light_ranges;
+	PackedColorArray light_colors;
+	for (const TRRoomLight &room_light : p_room.lights) {
+		light_positions.push_back(Vector3(
+			room_light.pos.x * TR_TO_GODOT_SCALE,
+			room_light.pos.y * -TR_TO_GODOT_SCALE,
+			room_light.pos.z * -TR_TO_GODOT_SCALE));
+		light_ranges.push_back(room_light.range);
+		light_colors.push_back(room_light.color * room_light.energy);
+	}
+	room_lighting["light_positions"] = light_positions;
+	room_lighting["light_ranges"] = light_ranges;
+	room_lighting["light_colors"] = light_colors;
+	return room_lighting;
+}
+
+// Portal graph and sector grid of one room, in the form TRRoomVisibility reads them.
+Dictionary get_tr_room_visibility_data(const TRRoom &p_room, const NodePath &p_node_path) {
+	Dictionary room_data;
+	room_data["node"] = p_node_path;
+	room_data["sector_origin"] = Vector2(p_room.info.x * TR_TO_GODOT_SCALE, p_room.info.z * TR_TO_GODOT_SCALE);
+	room_data["sector_size"] = TR_SQUARE_SIZE;
+	room_data["sector_columns"] = p_room.sector_count_z;
+	room_data["sector_rows"] = p_room.sector_count_x;
+
+	PackedFloat32Array sector_floors;
+	PackedFloat32Array sector_ceilings;
+	for (const TRRoomSector &room_sector : p_room.sectors) {
+		sector_floors.push_back((real_t)(-room_sector.floor) * TR_CLICK_SIZE);
+		sector_ceilings.push_back((real_t)(-room_sector.ceiling) * TR_CLICK_SIZE);
+	}
+	room_data["sector_floors"] = sector_floors;
+	room_data["sector_ceilings"] = sector_ceilings;
+
+	PackedInt32Array portal_rooms;
+	PackedVector3Array portal_normals;
+	PackedVector3Array portal_vertices;
+	for (const TRRoomPortal &room_portal : p_room.portals) {
+		portal_rooms.push_back(room_portal.adjoining_room);
+		portal_normals.push_back(Vector3(room_portal.normal.x, -room_portal.normal.y, -room_portal.normal.z).normalized());
+		for (const TRPos &portal_vertex : room_portal.vertices) {
+			portal_vertices.push_back(Vector3(
+				(p_room.info.x + portal_vertex.x) * TR_TO_GODOT_SCALE,
+				portal_vertex.y * -TR_TO_GODOT_SCALE,
+				(p_room.info.z + portal_vertex.z) * -TR_TO_GODOT_SCALE));
+		}
+	}
+	room_data["portal_rooms"] = portal_rooms;
+	room_data["portal_normals"] = portal_normals;
+	room_data["portal_vertices"] = portal_vertices;
+
+	return room_data;
+}
+
+// Sector grid of one room with its floor data decoded, in the form
+// TRLevelCollision reads it.
+Dictionary get_tr_room_collision_data(const TRRoom &p_room, const PackedByteArray &p_floor_data) {
+	Dictionary room_data;
+	room_data["sector_origin"] = Vector2(p_room.info.x * TR_TO_GODOT_SCALE, p_room.info.z * TR_TO_GODOT_SCALE);
+	room_data["sector_size"] = TR_SQUARE_SIZE;
+	room_data["sector_columns"] = p_room.sector_count_z;
+	room_data["sector_rows"] = p_room.sector_count_x;
+
+	PackedFloat32Array floor_corners;
+	PackedFloat32Array ceiling_corners;
+	PackedByteArray flags;
+	PackedInt32Array rooms_below;
+	PackedInt32Array rooms_above;
+	PackedInt32Array portal_rooms;
+	for (const TRRoomSector &room_sector : p_room.sectors) {
+		GeometryShift geo_shift = parse_floor_data_entry(p_floor_data, room_sector.floor_data_index);
+
+		floor_corners.push_back((real_t)(-room_sector.floor + geo_shift.nw_floor_shift) * TR_CLICK_SIZE);
+		floor_corners.push_back((real_t)(-room_sector.floor + geo_shift.ne_floor_shift) * TR_CLICK_SIZE);
+		floor_corners.push_back((real_t)(-room_sector.floor + geo_shift.sw_floor_shift) * TR_CLICK_SIZE);
+		floor_corners.push_back((real_t)(-room_sector.floor + geo_shift.se_floor_shift) * TR_CLICK_SIZE);
+
+		ceiling_corners.push_back((real_t)(-room_sector.ceiling + geo_shift.nw_ceiling_shift) * TR_CLICK_SIZE);
+		ceiling_corners.push_back((real_t)(-room_sector.ceiling + geo_shift.ne_ceiling_shift) * TR_CLICK_SIZE);
+		ceiling_corners.push_back((real_t)(-room_sector.ceiling + geo_shift.sw_ceiling_shift) * TR_CLICK_SIZE);
+		ceiling_corners.push_back((real_t)(-room_sector.ceiling + geo_shift.se_ceiling_shift) * TR_CLICK_SIZE);
+
+		uint8_t sector_flags = 0;
+		if (room_sector.floor == -127) {
+			sector_flags |= TR_COLLISION_SECTOR_WALL;
+		}
+		if (geo_shift.rotate_floor_triangles) {
+			sector_flags |= TR_COLLISION_SECTOR_FLOOR_SPLIT_NW_SE;
+		}
+		if (geo_shift.cull_first_floor_triangle) {
+			sector_flags |= TR_COLLISION_SECTOR_FLOOR_FIRST_PORTAL;
+		}
+		if (geo_shift.cull_second_floor_triangle) {
+			sector_flags |= TR_COLLISION_SECTOR_FLOOR_SECOND_PORTAL;
+		}
+		if (geo_shift.rotate_ceiling_triangles) {
+			sector_flags |= TR_COLLISION_SECTOR_CEILING_SPLIT_NW_SE;
+		}
+		if (geo_shift.cull_first_ceiling_triangle) {
+			sector_flags |= TR_COLLISION_SECTOR_CEILING_FIRST_PORTAL;
+		}
+		if (geo_shift.cull_second_ceiling_triangle) {
+			sector_flags |= TR_COLLISION_SECTOR_CEILING_SECOND_PORTAL;
+		}
+		flags.push_back(sector_flags);
+
+		rooms_below.push_back(room_sector.room_below == 0xff ? -1 : room_sector.room_below);
+		rooms_above.push_back(room_sector.room_above == 0xff ? -1 : room_sector.room_above);
+		portal_rooms.push_back(geo_shift.portal_room == 0xff ? -1 : geo_shift.portal_room);
+	}
+	room_data["sector_floor_corners"] = floor_corners;
+	room_data["sector_ceiling_corners"] = ceiling_corners;
+	room_data["sector_flags"] = flags;
+	room_data["sector_rooms_below"] = rooms_below;
+	room_data["sector_rooms_above"] = rooms_above;
+	room_data["sector_portal_rooms"] = portal_rooms;
+
+	return room_data;
+}
+
+
+// Room whose sector grid and height range hold a level position, or -1. The
+// first match wins where alternate rooms overlap.
+int32_t find_tr_room_for_position(const Vector<TRRoom> &p_rooms, const TRPos &p_position) {
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		const TRRoom &room = p_rooms[room_idx];
+		int32_t z_sector = (p_position.x - room.info.x) >> 10;
+		int32_t x_sector = (p_position.z - room.info.z) >> 10;
+		if (z_sector < 0 || z_sector >= room.sector_count_z || x_sector < 0 || x_sector >= room.sector_count_x) {
+			continue;
+		}
+		if (p_position.y < room.info.y_top || p_position.y > room.info.y_bottom) {
+			continue;
+		}
+		return room_idx;
+	}
+	return -1;
+}
+
+// The level's ambient sound sources, in the form TRSoundSources reads them.
+// Sound ids go through the sound map to the same sample sets the entities use.
+Array get_tr_sound_source_data(const Ref<TRLevelData> &p_level_data, const Vector<Ref<AudioStream>> &p_samples) {
+	Array sources;
+	for (const TRObjectVector &sound_source : p_level_data->sound_sources) {
+		uint16_t sound_id = sound_source.data;
+		if (sound_id >= p_level_data->sound_map.size()) {
+			continue;
+		}
+
+		uint16_t sound_info_id = p_level_data->sound_map[sound_id];
+		if (sound_info_id >= p_samples.size() || sound_info_id >= p_level_data->sound_infos.size()) {
+			continue;
+		}
+
+		const TRSoundInfo &sound_info = p_level_data->sound_infos[sound_info_id];
+		Ref<AudioStream> stream = p_samples[sound_info_id];
+		if (stream.is_null() || sound_info.volume == 0) {
+			continue;
+		}
+
+		Dictionary source;
+		source["position"] = Vector3(
+			sound_source.pos.x * TR_TO_GODOT_SCALE,
+			sound_source.pos.y * -TR_TO_GODOT_SCALE,
+			sound_source.pos.z * -TR_TO_GODOT_SCALE);
+		source["room"] = find_tr_room_for_position(p_level_data->rooms, sound_source.pos);
+		source["stream"] = stream;
+		source["priority"] = sound_info.volume;
+		source["volume_db"] = Math::linear_to_db(MIN(real_t(sound_info.volume) / 0x7fff, 1.0));
+		source["max_distance"] = real_t(sound_info.range) * TR_SQUARE_SIZE;
+		source["looping"] = stream->get_meta("tr_loop_mode", "") == "looping_enabled";
+		sources.push_back(source);
+	}
+	return sources;
+}
+
+Ref<Material> generate_tr_godot_generic_material(Ref<ImageTexture> p_image_texture, bool p_is_transparent, bool p_mipmaps = false) {
+	Ref<StandardMaterial3D> new_material = memnew(StandardMaterial3D);
+
+	new_material->set_diffuse_mode(BaseMaterial3D::DIFFUSE_LAMBERT_WRAP);
+	new_material->set_shading_mode(BaseMaterial3D::SHADING_MODE_PER_VERTEX);
+	new_material->set_specular(0.0);
+	new_material->set_roughness(1.0);
+	new_material->set_metallic(0.0);
+	new_material->set_flag(BaseMaterial3D::FLAG_ALBEDO_FROM_VERTEX_COLOR, true);
+	new_material->set_texture(BaseMaterial3D::TEXTURE_ALBEDO, p_image_texture);
+	new_material->set_texture_filter(p_mipmaps ? BaseMaterial3D::TEXTURE_FILTER_NEAREST_WITH_MIPMAPS : BaseMaterial3D::TEXTURE_FILTER_NEAREST);
+	new_material->set_flag(BaseMaterial3D::Flags::FLAG_USE_TEXTURE_REPEAT, false);
+	if (p_is_transparent) {
+		new_material->set_transparency(BaseMaterial3D::TRANSPARENCY_ALPHA_SCISSOR);
+	}
+
+	return new_material;
+}
+
+
+void set_owner_recursively(Node *p_node, Node *p_owner) {
+	p_node->set_owner(p_owner);
+	for (int32_t i = 0; i < p_node->get_child_count(); i++) {
+		set_owner_recursively(p_node->get_child(i), p_owner);
+	}
+}
+
+// Copies an RGBA8 rectangle row by row and replicates its edge texels p_padding pixels
+// outwards on every side, which keeps filtering inside the chart at its borders.
+void copy_rgba8_chart(Ref<Image> p_target_image, Point2i p_target_position, Ref<Image> p_source_image, Rect2i p_source_rect, int32_t p_padding = 0) {
+	ERR_FAIL_COND(p_target_image->get_format() != Image::FORMAT_RGBA8 || p_source_image->get_format() != Image::FORMAT_RGBA8);
+	ERR_FAIL_COND(!p_source_rect.has_area() || !Rect2i(Point2i(), p_source_image->get_size()).encloses(p_source_rect));
+	ERR_FAIL_COND(!Rect2i(Point2i(), p_target_image->get_size()).encloses(Rect2i(p_target_position, p_source_rect.size).grow(p_padding)));
+
+	const int32_t source_width = p_source_image->get_width();
+	const int32_t target_width = p_target_image->get_width();
+	const uint8_t *src = p_source_image->ptr();
+	uint8_t *dst = p_target_image->ptrw();
+
+	for (int32_t y = -p_padding; y < p_source_rect.size.height + p_padding; y++) {
+		int32_t source_y = p_source_rect.position.y + CLAMP(y, 0, p_source_rect.size.height - 1);
+		const uint8_t *source_row = &src[(source_y * source_width + p_source_rect.position.x) * 4];
+		uint8_t *target_row = &dst[((p_target_position.y + y) * target_width + p_target_position.x) * 4];
+
+		memcpy(target_row, source_row, p_source_rect.size.width * 4);
+		for (int32_t x = 1; x <= p_padding; x++) {
+			memcpy(target_row - x * 4, source_row, 4);
+			memcpy(target_row + (p_source_rect.size.width - 1 + x) * 4, source_row + (p_source_rect.size.width - 1) * 4, 4);
+		}
+	}
+}
+
+// Cuts an RGBA8 rectangle, clipped to the source, into a new image without an intermediate blit.
+Ref<Image> extract_rgba8_chart(Ref<Image> p_source_image, Rect2i p_source_rect) {
+	ERR_FAIL_COND_V(p_source_image->get_format() != Image::FORMAT_RGBA8, Ref<Image>());
+	Rect2i rect = p_source_rect.intersection(Rect2i(Point2i(), p_source_image->get_size()));
+	ERR_FAIL_COND_V(!rect.has_area(), Ref<Image>());
+
+	PackedByteArray data;
+	data.resize(rect.size.width * rect.size.height * 4);
+	uint8_t *dst = data.ptrw();
+	const uint8_t *src = p_source_image->ptr();
+	for (int32_t y = 0; y < rect.size.height; y++) {
+		memcpy(&dst[y * rect.size.width * 4], &src[((rect.position.y + y) * p_source_image->get_width() + rect.position.x) * 4], rect.size.width * 4);
+	}
+
+	return Image::create_from_data(rect.size.width, rect.size.height, false, Image::FORMAT_RGBA8, data);
+}
+
+// Streaming 64-bit hash in the style of xxHash64: eight bytes per round, with a
+// carry buffer so rows that aren't a multiple of eight bytes can be fed one by one.
+class TRStreamingHash64 {
+	static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+	static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+	static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+	static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+
+	uint64_t state = PRIME_3;
+	uint64_t length = 0;
+	uint64_t carry = 0;
+	uint32_t carry_size = 0;
+
+	static _FORCE_INLINE_ uint64_t rotate_left(uint64_t p_value, uint32_t p_bits) {
+		return (p_value << p_bits) | (p_value >> (64 - p_bits));
+	}
+
+	_FORCE_INLINE_ void consume(uint64_t p_word) {
+		p_word *= PRIME_2;
+		p_word = rotate_left(p_word, 31);
+		p_word *= PRIME_1;
+		state ^= p_word;
+		state = rotate_left(state, 27) * PRIME_1 + PRIME_4;
+	}
+
+public:
+	void update(const uint8_t *p_data, uint64_t p_size) {
+		length += p_size;
+
+		while (carry_size > 0 && p_size > 0) {
+			carry |= uint64_t(*p_data) << (carry_size * 8);
+			p_data++;
+			p_size--;
+			if (++carry_size == 8) {
+				consume(carry);
+				carry = 0;
+				carry_size = 0;
+			}
+		}
+
+		while (p_size >= 8) {
+			uint64_t word;
+			memcpy(&word, p_data, 8);
+			consume(word);
+			p_data += 8;
+			p_size -= 8;
+		}
+
+		for (uint64_t i = 0; i < p_size; i++) {
+			carry |= uint64_t(p_data[i]) << (carry_size * 8);
+			carry_size++;
+		}
+	}
+
+	void update_u32(uint32_t p_value) {
+		update(reinterpret_cast<const uint8_t *>(&p_value), sizeof(p_value));
+	}
+
+	uint64_t finish() const {
+		uint64_t hash = state;
+		if (carry_size > 0) {
+			hash ^= (carry * PRIME_1);
+			hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+		}
+		hash ^= length;
+		hash ^= hash >> 33;
+		hash *= PRIME_2;
+		hash ^= hash >> 29;
+		hash *= PRIME_3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+};
+
+// Hashes an RGBA8 rectangle straight from the rows of its page, so charts can be
+// matched before (or without) being cut out. The whole image is the default rect.
+uint64_t get_hash_for_image(Ref<Image> p_image, Rect2i p_rect = Rect2i()) {
+	if (!p_rect.has_area()) {
+		p_rect = Rect2i(Point2i(), p_image->get_size());
+	}
+
+	TRStreamingHash64 hash;
+	hash.update_u32(p_rect.size.width);
+	hash.update_u32(p_rect.size.height);
+	hash.update_u32(p_image->get_format());
+
+	if (p_rect == Rect2i(Point2i(), p_image->get_size())) {
+		hash.update(p_image->ptr(), p_image->get_data_size());
+	} else {
+		ERR_FAIL_COND_V(p_image->get_format() != Image::FORMAT_RGBA8, 0);
+		ERR_FAIL_COND_V(!Rect2i(Point2i(), p_image->get_size()).encloses(p_rect), 0);
+
+		const uint8_t *data = p_image->ptr();
+		for (int32_t y = p_rect.position.y; y < p_rect.get_end().y; y++) {
+			hash.update(&data[(y * p_image->get_width() + p_rect.position.x) * 4], p_rect.size.width * 4);
+		}
+	}
+
+	return hash.finish();
+}
+
+// Compares an RGBA8 rectangle of a page against a chart image, row by row.
+bool rgba8_chart_equals(Ref<Image> p_image, Rect2i p_rect, Ref<Image> p_chart_image) {
+	if (p_chart_image->get_size() != p_rect.size || p_image->get_format() != Image::FORMAT_RGBA8 || p_chart_image->get_format() != Image::FORMAT_RGBA8) {
+		return false;
+	}
+
+	const uint8_t *data = p_image->ptr();
+	const uint8_t *chart_data = p_chart_image->ptr();
+	for (int32_t y = 0; y < p_rect.size.height; y++) {
+		if (memcmp(&data[((p_rect.position.y + y) * p_image->get_width() + p_rect.position.x) * 4], &chart_data[y * p_rect.size.width * 4], p_rect.size.width * 4) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Block compressors fit each block's endpoints to all of its texels, so the black
+// behind a cutout would drag the visible colours towards it. Transparent texels
+// take the average colour of their opaque neighbours instead; alpha is untouched.
+void fill_transparent_texels(Ref<Image> p_image) {
+	ERR_FAIL_COND(p_image->get_format() != Image::FORMAT_RGBA8);
+
+	int32_t width = p_image->get_width();
+	int32_t height = p_image->get_height();
+	uint8_t *data = p_image->ptrw();
+
+	const Point2i neighbours[4] = { Point2i(-1, 0), Point2i(1, 0), Point2i(0, -1), Point2i(0, 1) };
+	for (int32_t y = 0; y < height; y++) {
+		for (int32_t x = 0; x < width; x++) {
+			uint8_t *texel = &data[(y * width + x) * 4];
+			if (texel[3] != 0) {
+				continue;
+			}
+
+			int32_t sum[3] = { 0, 0, 0 };
+			int32_t count = 0;
+			for (const Point2i &offset : neighbours) {
+				Point2i neighbour = Point2i(x, y) + offset;
+				if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x >= width || neighbour.y >= height) {
+					continue;
+				}
+				const uint8_t *neighbour_texel = &data[(neighbour.y * width + neighbour.x) * 4];
+				if (neighbour_texel[3] == 0) {
+					continue;
+				}
+				for (int32_t c = 0; c < 3; c++) {
+					sum[c] += neighbour_texel[c];
+				}
+				count++;
+			}
+
+			if (count > 0) {
+				for (int32_t c = 0; c < 3; c++) {
+					texel[c] = sum[c] / count;
+				}
+			}
+		}
+	}
+}
+
+// Returns the original image when the compressor for the requested format isn't available.
+// p_force_alpha compresses opaque pages with the alpha format too (BC3 rather
+// than BC1 for S3TC), for texture arrays which need every layer in one format.
+Ref<Image> compress_tr_texture_image(Ref<Image> p_image, TRTextureCompression p_compression, bool p_force_alpha) {
+	Image::CompressMode compress_mode;
+	switch (p_compression) {
+		case TR_TEXTURE_COMPRESSION_S3TC:
+			compress_mode = Image::COMPRESS_S3TC;
+			break;
+		case TR_TEXTURE_COMPRESSION_BPTC:
+			compress_mode = Image::COMPRESS_BPTC;
+			break;
+		case TR_TEXTURE_COMPRESSION_ETC2:
+			compress_mode = Image::COMPRESS_ETC2;
+			break;
+		default:
+			return p_image;
+	}
+
+	Ref<Image> compressed_image = p_image->duplicate();
+	if (compressed_image->get_format() != Image::FORMAT_RGBA8) {
+		compressed_image->convert(Image::FORMAT_RGBA8);
+	}
+	fill_transparent_texels(compressed_image);
+
+	// Otherwise the compressors pick an alpha format on their own when a page has cutouts.
+	Error err = p_force_alpha ? compressed_image->compress_from_channels(compress_mode, Image::USED_CHANNELS_RGBA) : compressed_image->compress(compress_mode, Image::COMPRESS_SOURCE_GENERIC);
+	ERR_FAIL_COND_V_MSG(err != OK || !compressed_image->is_compressed(), p_image, "Could not compress texture page, keeping it uncompressed.");
+
+	return compressed_image;
+}
+
+// Chart rectangles of every texture page, taken from the texture infos that sample it.
+Vector<Vector<Rect2i>> get_tr_texture_page_charts(const Vector<TRTextureInfo> &p_texture_infos, int32_t p_page_count) {
+	Vector<Vector<Rect2i>> page_charts;
+	page_charts.resize(p_page_count);
+
+	for (const TRTextureInfo &texture_info : p_texture_infos) {
+		if (texture_info.texture_page >= p_page_count) {
+			continue;
+		}
+
+		// Triangle texture infos leave the fourth corner at zero.
+		int32_t corner_count = (texture_info.uv[3].u == 0 && texture_info.uv[3].v == 0) ? 3 : 4;
+		Rect2i rect = Rect2i(texture_info.uv[0].u >> 8, texture_info.uv[0].v >> 8, 1, 1);
+		for (int32_t j = 1; j < corner_count; j++) {
+			rect = rect.expand(Point2i(texture_info.uv[j].u >> 8, texture_info.uv[j].v >> 8));
+		}
+		rect.size += Size2i(1, 1);
+
+		page_charts.write[texture_info.texture_page].push_back(rect);
+	}
+
+	return page_charts;
+}
+
+// Builds the mip chain of a texture page one chart at a time: a mip texel only averages
+// the base texels of the chart under its centre, so minified charts never pick up their
+// neighbours. Alpha stays 1-bit so cutouts survive the alpha scissor at every level.
+Ref<Image> generate_tr_chart_mipmaps(Ref<Image> p_image, const Vector<Rect2i> &p_charts) {
+	ERR_FAIL_COND_V(p_image->get_format() != Image::FORMAT_RGBA8 || p_image->has_mipmaps(), p_image);
+
+	int32_t width = p_image->get_width();
+	int32_t height = p_image->get_height();
+	Rect2i page_rect = Rect2i(0, 0, width, height);
+
+	// Chart owning each base texel, or -1 for texels outside every chart. Smaller charts
+	// claim their texels first, so overlapping regions favour the tighter chart.
+	Vector<Rect2i> sorted_charts = p_charts;
+	struct SortChartsByArea {
+		bool operator()(const Rect2i &p_a, const Rect2i &p_b) const {
+			return p_a.get_area() < p_b.get_area();
+		}
+	};
+	sorted_charts.sort_custom<SortChartsByArea>();
+
+	LocalVector<int32_t> owners;
+	owners.resize(width * height);
+	for (int32_t &owner : owners) {
+		owner = -1;
+	}
+	for (int32_t i = 0; i < sorted_charts.size(); i++) {
+		Rect2i rect = sorted_charts[i].intersection(page_rect);
+		for (int32_t y = rect.position.y; y < rect.get_end().y; y++) {
+			for (int32_t x = rect.position.x; x < rect.get_end().x; x++) {
+				if (owners[y * width + x] < 0) {
+					owners[y * width + x] = i;
+				}
+			}
+		}
+	}
+
+	PackedByteArray data;
+	data.resize(Image::get_image_data_size(width, height, Image::FORMAT_RGBA8, true));
+	uint8_t *dst = data.ptrw();
+	memcpy(dst, p_image->ptr(), width * height * 4);
+
+	// Edge extension: texels outside every chart copy an adjacent chart texel and join
+	// its chart, a few texels deep, so minified charts average their own edge colour
+	// instead of whatever lies next to them. Atlas charts already include the packer's
+	// padding; original pages pack their charts edge to edge and only grow into gaps.
+	const int32_t edge_extension = 2;
+	const Point2i neighbour_offsets[4] = { Point2i(-1, 0), Point2i(1, 0), Point2i(0, -1), Point2i(0, 1) };
+	LocalVector<int32_t> extended_texels;
+	LocalVector<int32_t> extended_sources;
+	for (int32_t pass = 0; pass < edge_extension; pass++) {
+		extended_texels.clear();
+		extended_sources.clear();
+		for (int32_t y = 0; y < height; y++) {
+			for (int32_t x = 0; x < width; x++) {
+				if (owners[y * width + x] >= 0) {
+					continue;
+				}
+				for (const Point2i &offset : neighbour_offsets) {
+					Point2i neighbour = Point2i(x, y) + offset;
+					if (page_rect.has_point(neighbour) && owners[neighbour.y * width + neighbour.x] >= 0) {
+						extended_texels.push_back(y * width + x);
+						extended_sources.push_back(neighbour.y * width + neighbour.x);
+						break;
+					}
+				}
+			}
+		}
+		if (extended_texels.is_empty()) {
+			break;
+		}
+		for (uint32_t i = 0; i < extended_texels.size(); i++) {
+			owners[extended_texels[i]] = owners[extended_sources[i]];
+			memcpy(&dst[extended_texels[i] * 4], &dst[extended_sources[i] * 4], 4);
+		}
+	}
+	const uint8_t *src = dst;
+
+	int32_t mipmap_count = Image::get_image_required_mipmaps(width, height, Image::FORMAT_RGBA8);
+	for (int32_t mipmap = 1; mipmap <= mipmap_count; mipmap++) {
+		int32_t mipmap_width = 0;
+		int32_t mipmap_height = 0;
+		int64_t offset = Image::get_image_mipmap_offset_and_dimensions(width, height, Image::FORMAT_RGBA8, mipmap, mipmap_width, mipmap_height);
+		uint8_t *mipmap_dst = &dst[offset];
+
+		for (int32_t my = 0; my < mipmap_height; my++) {
+			int32_t y_begin = my * height / mipmap_height;
+			int32_t y_end = MAX((my + 1) * height / mipmap_height, y_begin + 1);
+			for (int32_t mx = 0; mx < mipmap_width; mx++) {
+				int32_t x_begin = mx * width / mipmap_width;
+				int32_t x_end = MAX((mx + 1) * width / mipmap_width, x_begin + 1);
+
+				int32_t owner = owners[((y_begin + y_end) / 2) * width + (x_begin + x_end) / 2];
+
+				uint32_t sum[3] = { 0, 0, 0 };
+				uint32_t opaque_count = 0;
+				uint32_t total_count = 0;
+				for (int32_t y = y_begin; y < y_end; y++) {
+					for (int32_t x = x_begin; x < x_end; x++) {
+						if (owners[y * width + x] != owner) {
+							continue;
+						}
+						total_count++;
+
+						const uint8_t *texel = &src[(y * width + x) * 4];
+						if (texel[3] == 0) {
+							continue;
+						}
+						for (int32_t c = 0; c < 3; c++) {
+							sum[c] += texel[c];
+						}
+						opaque_count++;
+					}
+				}
+
+				uint8_t *mipmap_texel = &mipmap_dst[(my * mipmap_width + mx) * 4];
+				for (int32_t c = 0; c < 3; c++) {
+					mipmap_texel[c] = opaque_count > 0 ? sum[c] / opaque_count : 0;
+				}
+				mipmap_texel[3] = (opaque_count * 2 >= total_count) ? 255 : 0;
+			}
+		}
+	}
+
+	return Image::create_from_data(width, height, true, Image::FORMAT_RGBA8, data);
+}
+
+// Skyline bottom-left rectangle packer. The skyline is the upper outline of
+// everything placed so far, so a placement only has to check the segments
+// under the new rectangle instead of every placed rectangle.
+class TRSkylinePacker {
+	struct SkylineNode {
+		int32_t x = 0;
+		int32_t y = 0;
+		int32_t width = 0;
+	};
+
+	LocalVector<SkylineNode> skyline;
+	Size2i size;
+
+	// Returns the height a rectangle rests at with its left edge on the given node, or -1 if it doesn't fit.
+	int32_t get_fit_height(uint32_t p_node_index, const Size2i &p_rect_size) const {
+		int32_t x = skyline[p_node_index].x;
+		if (x + p_rect_size.width > size.width) {
+			return -1;
+		}
+
+		int32_t y = 0;
+		int32_t width_left = p_rect_size.width;
+		for (uint32_t i = p_node_index; width_left > 0 && i < skyline.size(); i++) {
+			y = MAX(y, skyline[i].y);
+			if (y + p_rect_size.height > size.height) {
+				return -1;
+			}
+			width_left -= skyline[i].width;
+		}
+
+		return y;
+	}
+
+	void add_skyline_level(uint32_t p_node_index, const Rect2i &p_rect) {
+		SkylineNode new_node;
+		new_node.x = p_rect.position.x;
+		new_node.y = p_rect.position.y + p_rect.size.height;
+		new_node.width = p_rect.size.width;
+		skyline.insert(p_node_index, new_node);
+
+		// Cut the nodes now shadowed by the new one.
+		for (uint32_t i = p_node_index + 1; i < skyline.size(); i++) {
+			const SkylineNode &previous = skyline[i - 1];
+			int32_t previous_end = previous.x + previous.width;
+			if (skyline[i].x >= previous_end) {
+				break;
+			}
+
+			int32_t shrink = previous_end - skyline[i].x;
+			skyline[i].x += shrink;
+			skyline[i].width -= shrink;
+			if (skyline[i].width > 0) {
+				break;
+			}
+			skyline.remove_at(i);
+			i--;
+		}
+
+		// Merge neighbouring nodes at the same height.
+		for (uint32_t i = 0; i + 1 < skyline.size(); i++) {
+			if (skyline[i].y == skyline[i + 1].y) {
+				skyline[i].width += skyline[i + 1].width;
+				skyline.remove_at(i + 1);
+				i--;
+			}
+		}
+	}
+
+public:
+	void reset(const Size2i &p_size) {
+		size = p_size;
+		skyline.clear();
+
+		SkylineNode root;
+		root.width = p_size.width;
+		skyline.push_back(root);
+	}
+
+	int32_t get_used_height() const {
+		int32_t used_height = 0;
+		for (const SkylineNode &node : skyline) {
+			used_height = MAX(used_height, node.y);
+		}
+		return used_height;
+	}
+
+	// Places the rectangle at the lowest possible position, preferring the narrowest segment on ties.
+	bool insert(const Size2i &p_rect_size, Point2i &r_position) {
+		int32_t best_node_index = -1;
+		int32_t best_bottom = INT32_MAX;
+		int32_t best_width = INT32_MAX;
+
+		for (uint32_t i = 0; i < skyline.size(); i++) {
+			int32_t y = get_fit_height(i, p_rect_size);
+			if (y < 0) {
+				continue;
+			}
+
+			int32_t bottom = y + p_rect_size.height;
+			if (bottom < best_bottom || (bottom == best_bottom && skyline[i].width < best_width)) {
+				best_node_index = i;
+				best_bottom = bottom;
+				best_width = skyline[i].width;
+				r_position = Point2i(skyline[i].x, y);
+			}
+		}
+
+		if (best_node_index < 0) {
+			return false;
+		}
+
+		add_skyline_level(best_node_index, Rect2i(r_position, p_rect_size));
+		return true;
+	}
+
+	TRSkylinePacker(const Size2i &p_size) {
+		reset(p_size);
+	}
+};
+
+struct TRTextureInfoRemapInfoChart {
+	Point2i src_points[4];
+	uint32_t src_texture_page_id;
+	uint32_t src_chart_id;
+};
+
+struct TRTexturePageAtlas {
+	Vector<Rect2i> used_charts;
+};
+
+// One bit per texture info id; read_tr_texture_infos caps a level at 8192 of them.
+// Face ids from TR3 on carry a double-sided flag in their top bit, which is
+// dropped here. Ids past the cap can't name a texture info and are ignored.
+class TRTextureInfoIdSet {
+	static constexpr uint32_t MAX_TEXTURE_INFOS = 8192;
+	uint64_t bits[MAX_TEXTURE_INFOS / 64] = {};
+
+public:
+	void insert(uint32_t p_id) {
+		p_id &= 0x7fff;
+		if (p_id >= MAX_TEXTURE_INFOS) {
+			return;
+		}
+		bits[p_id >> 6] |= uint64_t(1) << (p_id & 63);
+	}
+
+	bool has(uint32_t p_id) const {
+		return p_id < MAX_TEXTURE_INFOS && (bits[p_id >> 6] & (uint64_t(1) << (p_id & 63)));
+	}
+};
+
+struct TRMoveableReAtlasResult {
+	//HashMap<uint32_t, TRMoveableReAtlasedMeshData> mesh_table;
+	Vector<Ref<Image>> custom_atlases;
+};
+
+TRMoveableReAtlasResult reatlas_object_group_textures(
+	const Vector<TRMoveableInfo> p_moveable_infos,
+	const Vector<TRMesh> &p_meshes,
+	const Vector<TRTextureInfo> p_texture_infos,
+	const Vector<Ref<Image>> p_images) {
+
+	// This is a pretty suboptimal texture-atlas creator, but it should hopefully be *good enough* for now.
+
+	Vector<TRTextureInfoRemapInfoChart> texture_info_remaps;
 	texture_info_remaps.resize(p_texture_infos.size());
 
 	TRMoveableReAtlasResult result;
 	HashMap<uint16_t, TRTexturePageAtlas> atlases;
+	HashMap<uint16_t, HashMap<Rect2i, int64_t>> atlas_chart_indices;
 	Vector<uint16_t> used_texture_pages;
+	HashSet<uint16_t> used_texture_page_set;
 
 	HashMap<uint32_t, TRTextureInfoRemapInfoChart> remapped_texture_infos;
 
@@ -3689,16 +5175,20 @@ TRMoveableReAtlasResult reatlas_object_group_textures(
 						texture_rect.expand_to(uv[3]);
 
 						// Mark the texture page as having been used.
-						if (!used_texture_pages.has(texture_page_id)) {
+						if (!used_texture_page_set.has(texture_page_id)) {
+							used_texture_page_set.insert(texture_page_id);
 							used_texture_pages.append(texture_page_id);
 						}
 
 						// Add the chart to the list of the ones we've used for the original texture page.
-						int64_t chart_index = atlases[texture_page_id].used_charts.find(texture_rect);
-						if (chart_index < 0) {
-							if (atlases[texture_page_id].used_charts.append(texture_rect)) {
-								chart_index = atlases[texture_page_id].used_charts.size() - 1;
-							}
+						HashMap<Rect2i, int64_t> &chart_indices = atlas_chart_indices[texture_page_id];
+						int64_t chart_index = -1;
+						if (HashMap<Rect2i, int64_t>::Iterator E = chart_indices.find(texture_rect)) {
+							chart_index = E->value;
+						} else {
+							chart_index = atlases[texture_page_id].used_charts.size();
+							atlases[texture_page_id].used_charts.push_back(texture_rect);
+							chart_indices.insert(texture_rect, chart_index);
 						}
 
 						// Write the exact UV positions here with the corresponding chart.
@@ -3730,16 +5220,20 @@ TRMoveableReAtlasResult reatlas_object_group_textures(
 						texture_rect.expand_to(uv[2]);
 
 						// Mark the texture page as having been used.
-						if (!used_texture_pages.has(texture_page_id)) {
+						if (!used_texture_page_set.has(texture_page_id)) {
+							used_texture_page_set.insert(texture_page_id);
 							used_texture_pages.append(texture_page_id);
 						}
 
 						// Add the chart to the list of the ones we've used for the original texture page.
-						int64_t chart_index = atlases[texture_page_id].used_charts.find(texture_rect);
-						if (chart_index < 0) {
-							if (atlases[texture_page_id].used_charts.append(texture_rect)) {
-								chart_index = atlases[texture_page_id].used_charts.size() - 1;
-							}
+						HashMap<Rect2i, int64_t> &chart_indices = atlas_chart_indices[texture_page_id];
+						int64_t chart_index = -1;
+						if (HashMap<Rect2i, int64_t>::Iterator E = chart_indices.find(texture_rect)) {
+							chart_index = E->value;
+						} else {
+							chart_index = atlases[texture_page_id].used_charts.size();
+							atlases[texture_page_id].used_charts.push_back(texture_rect);
+							chart_indices.insert(texture_rect, chart_index);
 						}
 
 						// Write the exact UV positions here with the corresponding chart.
@@ -3782,10 +5276,12 @@ TRMoveableReAtlasResult reatlas_object_group_textures(
 		uint32_t overall_size;
 		Point2i size;
 		Ref<Image> image;
+		uint64_t hash;
 		bool rotated;
 	};
 
 	Vector<TRSortedTextureAtlasChart> sorted_charts;
+	HashMap<uint64_t, int32_t> sorted_charts_by_hash;
 
 	const int32_t PADDING_PIXELS = 4;
 
@@ -3799,8 +5295,8 @@ TRMoveableReAtlasResult reatlas_object_group_textures(
 
 			Ref<Image> src_texture = p_images.get(used_texture_page_id);
 			
-			new_entry.image = memnew(Image(chart.size.width, chart.size.height, false, Image::FORMAT_RGBA8));
-			new_entry.image->blit_rect(src_texture, chart, Vector2i());
+			new_entry.image = extract_rgba8_chart(src_texture, chart);
+			ERR_CONTINUE(new_entry.image.is_null());
 
 			if (height > width) {
 				new_entry.size = Point2i(height, width);
@@ -3811,6 +5307,13 @@ TRMoveableReAtlasResult reatlas_object_group_textures(
 				new_entry.rotated = false;
 			}
 
+			// Identical charts from different pages only need to be packed once.
+			new_entry.hash = get_hash_for_image(new_entry.image);
+			if (sorted_charts_by_hash.has(new_entry.hash)) {
+				continue;
+			}
+			sorted_charts_by_hash.insert(new_entry.hash, sorted_charts.size());
+
 			new_entry.overall_size = new_entry.size.x * new_entry.size.y;
 			sorted_charts.append(new_entry);
 		}
@@ -3833,106 +5336,282 @@ TRMoveableReAtlasResult reatlas_object_group_textures(
 					} else if (p_a.size.x > p_b.size.x) {
 						return false;
 					} else {
-						uint32_t a_hash = get_hash_for_image(p_a.image);
-						uint32_t b_hash = get_hash_for_image(p_b.image);
-
-						if (a_hash >= b_hash) {
-							if (a_hash == b_hash) {
-								print_error("Hash collision occurred while sorting texture atlas charts.");
-							}
-							return true;
-						} else {
-							return false;
-						}
+						return p_a.hash > p_b.hash;
 					}
 				}
 			}
 		}
 	};
 
-	sorted_charts.sort_custom<SortAtlasCharts>();
+	sorted_charts.sort_custom<SortAtlasCharts>();
+
+	// The atlas width comes from the padded chart area, the height from whatever the skyline ends up using.
+	int64_t padded_area = 0;
+	int32_t widest_chart = 0;
+	for (const TRSortedTextureAtlasChart& sorted_chart : sorted_charts) {
+		padded_area += int64_t(sorted_chart.size.x + PADDING_PIXELS) * int64_t(sorted_chart.size.y + PADDING_PIXELS);
+		widest_chart = MAX(widest_chart, sorted_chart.size.x + PADDING_PIXELS);
+	}
+
+	int32_t atlas_width = MAX(next_power_of_2(uint32_t(Math::ceil(Math::sqrt(double(padded_area))))), next_power_of_2(uint32_t(widest_chart)));
+	TRSkylinePacker packer(Size2i(atlas_width, INT16_MAX));
+
+	Vector<Point2i> chart_positions;
+	for (const TRSortedTextureAtlasChart& sorted_chart : sorted_charts) {
+		Point2i position;
+		packer.insert(Size2i(sorted_chart.size.x + PADDING_PIXELS, sorted_chart.size.y + PADDING_PIXELS), position);
+		chart_positions.push_back(position + Point2i(PADDING_PIXELS / 2, PADDING_PIXELS / 2));
+	}
+
+	int32_t atlas_height = next_power_of_2(uint32_t(MAX(packer.get_used_height(), 1)));
+
+	Ref<Image> new_atlas = memnew(Image(atlas_width, atlas_height, false, Image::FORMAT_RGBA8));
+	ERR_FAIL_COND_V(new_atlas.is_null(), TRMoveableReAtlasResult());
+
+	for (int32_t i = 0; i < sorted_charts.size(); i++) {
+		const TRSortedTextureAtlasChart& sorted_chart = sorted_charts[i];
+		Rect2i src_rect = Rect2i(0, 0, sorted_chart.size.x, sorted_chart.size.y);
+
+		Ref<Image> src_texture = sorted_chart.image;
+
+		copy_rgba8_chart(new_atlas, chart_positions[i], src_texture, src_rect, PADDING_PIXELS / 2);
+	}
+
+	PackedByteArray pba = new_atlas->get_data();
+
+	result.custom_atlases.push_back(new_atlas);
+
+	String test_atlas_path = String("test_atlas") + String(".png");
+	new_atlas->save_png(test_atlas_path);
+
+	return result;
+}
+
+struct TRLevelTextureAtlas {
+	Vector<Ref<Image>> pages;
+	// Padded chart rectangles of each page.
+	Vector<Vector<Rect2i>> page_charts;
+	Vector<TRTextureInfoRemap> texture_info_remaps;
+};
+
+static void mark_tr_texture_info_corners(Vector<uint8_t> &r_corner_counts, uint16_t p_tex_info_id, uint8_t p_corner_count) {
+	if (p_tex_info_id < r_corner_counts.size()) {
+		r_corner_counts.write[p_tex_info_id] = MAX(r_corner_counts[p_tex_info_id], p_corner_count);
+	}
+}
+
+// Repacks every texture region referenced by the level's rooms and meshes into as few
+// pages as possible. Regions are cut out of their source page, deduplicated by content
+// and placed with a skyline packer, tallest first. Charts are never rotated.
+TRLevelTextureAtlas pack_level_texture_atlas(
+	const Vector<TRRoom> &p_rooms,
+	const Vector<TRMesh> &p_meshes,
+	const Vector<TRTextureInfo> &p_texture_infos,
+	const Vector<Ref<Image>> &p_images,
+	int32_t p_max_page_size = 2048,
+	int32_t p_padding = 4,
+	bool p_uniform_page_size = false) {
+	TRLevelTextureAtlas result;
+
+	// Triangles only reference the first three corners of their texture info.
+	Vector<uint8_t> corner_counts;
+	corner_counts.resize(p_texture_infos.size());
+	corner_counts.fill(0);
+
+	for (const TRRoom &room : p_rooms) {
+		for (const TRFaceQuad &quad : room.data.room_quads) {
+			mark_tr_texture_info_corners(corner_counts, quad.tex_info_id, 4);
+		}
+		for (const TRFaceTriangle &triangle : room.data.room_triangles) {
+			mark_tr_texture_info_corners(corner_counts, triangle.tex_info_id, 3);
+		}
+	}
+	for (const TRMesh &mesh : p_meshes) {
+		for (const TRFaceQuad &quad : mesh.texture_quads) {
+			mark_tr_texture_info_corners(corner_counts, quad.tex_info_id, 4);
+		}
+		for (const TRFaceTriangle &triangle : mesh.texture_triangles) {
+			mark_tr_texture_info_corners(corner_counts, triangle.tex_info_id, 3);
+		}
+	}
+
+	struct TRLevelAtlasChart {
+		Ref<Image> image;
+		Point2i position;
+		int32_t page = -1;
+	};
+
+	Vector<TRLevelAtlasChart> charts;
+	Vector<int32_t> texture_info_charts;
+	Vector<Rect2i> texture_info_rects;
+	texture_info_charts.resize(p_texture_infos.size());
+	texture_info_charts.fill(-1);
+	texture_info_rects.resize(p_texture_infos.size());
 
-	int32_t atlas_size = 32;
-	Point2i current_position(PADDING_PIXELS, PADDING_PIXELS);
-	int32_t max_row_height = 0;
+	HashMap<uint64_t, int32_t> charts_by_rect;
+	HashMap<uint64_t, LocalVector<int32_t>> charts_by_hash;
 
-	bool packing_successful = false;
-	while (!packing_successful) {
-		current_position = Point2i(PADDING_PIXELS, PADDING_PIXELS);
-		max_row_height = 0;
-		packing_successful = true;
+	for (int32_t i = 0; i < p_texture_infos.size(); i++) {
+		if (corner_counts[i] == 0) {
+			continue;
+		}
 
-		for (TRSortedTextureAtlasChart& sorted_chart : sorted_charts) {
-			Rect2i src_rect = Rect2i(0, 0, sorted_chart.size.x, sorted_chart.size.y);
+		const TRTextureInfo &texture_info = p_texture_infos[i];
+		if (texture_info.texture_page >= p_images.size() || p_images[texture_info.texture_page].is_null()) {
+			continue;
+		}
+		Ref<Image> page_image = p_images[texture_info.texture_page];
+
+		Point2i min = Point2i(INT32_MAX, INT32_MAX);
+		Point2i max = Point2i(INT32_MIN, INT32_MIN);
+		for (int32_t j = 0; j < corner_counts[i]; j++) {
+			Point2i pixel = Point2i(texture_info.uv[j].u >> 8, texture_info.uv[j].v >> 8);
+			min = min.min(pixel);
+			max = max.max(pixel);
+		}
+		max = max.min(Point2i(page_image->get_width() - 1, page_image->get_height() - 1));
 
-			if (current_position.x + (src_rect.size.x + PADDING_PIXELS) > atlas_size) {
-				current_position.x = PADDING_PIXELS;
-				current_position.y += max_row_height + PADDING_PIXELS;
-				max_row_height = 0;
-			}
+		Rect2i rect = Rect2i(min, max - min + Point2i(1, 1));
+		ERR_CONTINUE(!Rect2i(Point2i(), page_image->get_size()).encloses(rect));
+		texture_info_rects.write[i] = rect;
 
-			if (current_position.y + src_rect.size.y > atlas_size) {
-				atlas_size = (atlas_size << 1);
-				packing_successful = false;
+		uint64_t rect_key = (uint64_t(texture_info.texture_page) << 48) | (uint64_t(rect.position.x) << 36) | (uint64_t(rect.position.y) << 24) | (uint64_t(rect.size.x) << 12) | uint64_t(rect.size.y);
+		if (HashMap<uint64_t, int32_t>::Iterator E = charts_by_rect.find(rect_key)) {
+			texture_info_charts.write[i] = E->value;
+			continue;
+		}
+
+		// Different regions with identical pixels share one chart. The rows are hashed and
+		// compared in place, so only charts seen for the first time get cut out.
+		uint64_t hash = get_hash_for_image(page_image, rect);
+		int32_t chart_index = -1;
+		LocalVector<int32_t> &hash_charts = charts_by_hash[hash];
+		for (int32_t candidate : hash_charts) {
+			if (rgba8_chart_equals(page_image, rect, charts[candidate].image)) {
+				chart_index = candidate;
 				break;
 			}
-
-			current_position.x += (src_rect.size.x + PADDING_PIXELS);
-			max_row_height = MAX(max_row_height, (src_rect.size.y + PADDING_PIXELS));
 		}
-	}
 
-	int32_t atlas_width = atlas_size;
-	int32_t atlas_height = atlas_size;
+		if (chart_index < 0) {
+			Ref<Image> chart_image = extract_rgba8_chart(page_image, rect);
+			ERR_CONTINUE(chart_image.is_null());
 
-	// Reduce the vertical atlas size to as small as we can go.
-	current_position.y += max_row_height + PADDING_PIXELS;
-	while (current_position.y <= (atlas_height >> 1)) {
-		atlas_height = atlas_height >> 1;
-	}
+			chart_index = charts.size();
+			hash_charts.push_back(chart_index);
 
-	current_position = Point2i(PADDING_PIXELS, PADDING_PIXELS);
-	max_row_height = 0;
+			TRLevelAtlasChart chart;
+			chart.image = chart_image;
+			charts.push_back(chart);
+		}
 
-	Ref<Image> new_atlas = memnew(Image(atlas_width, atlas_height, false, Image::FORMAT_RGBA8));
-	ERR_FAIL_COND_V(new_atlas.is_null(), TRMoveableReAtlasResult());
+		charts_by_rect.insert(rect_key, chart_index);
+		texture_info_charts.write[i] = chart_index;
+	}
 
-	for (TRSortedTextureAtlasChart& sorted_chart : sorted_charts) {
-		Rect2i src_rect = Rect2i(0, 0, sorted_chart.size.x, sorted_chart.size.y);
+	if (charts.is_empty()) {
+		return result;
+	}
 
-		if (current_position.x + src_rect.size.x + PADDING_PIXELS > new_atlas->get_width()) {
-			current_position.x = PADDING_PIXELS;
-			current_position.y += max_row_height + PADDING_PIXELS;
-			max_row_height = 0;
-		}
+	struct TRSortedLevelAtlasChart {
+		int32_t index;
+		Size2i size;
 
-		if (current_position.y + src_rect.size.y > new_atlas->get_height()) {
-			continue;
+		bool operator<(const TRSortedLevelAtlasChart &p_other) const {
+			if (size.height != p_other.size.height) {
+				return size.height > p_other.size.height;
+			}
+			if (size.width != p_other.size.width) {
+				return size.width > p_other.size.width;
+			}
+			return index < p_other.index;
 		}
+	};
 
-		Ref<Image> src_texture = sorted_chart.image;
+	Vector<TRSortedLevelAtlasChart> sorted_charts;
+	int64_t padded_area = 0;
+	int32_t widest_chart = 0;
+	for (int32_t i = 0; i < charts.size(); i++) {
+		Size2i padded_size = charts[i].image->get_size() + Size2i(p_padding, p_padding);
+		padded_area += int64_t(padded_size.width) * int64_t(padded_size.height);
+		widest_chart = MAX(widest_chart, padded_size.width);
+		sorted_charts.push_back({ i, charts[i].image->get_size() });
+	}
+	sorted_charts.sort();
+
+	int32_t page_width = MAX(next_power_of_2(uint32_t(Math::ceil(Math::sqrt(double(padded_area))))), next_power_of_2(uint32_t(widest_chart)));
+	page_width = MIN(page_width, p_max_page_size);
+
+	// Charts that no longer fit spill over into a new page.
+	LocalVector<TRSkylinePacker> packers;
+	for (const TRSortedLevelAtlasChart &sorted_chart : sorted_charts) {
+		TRLevelAtlasChart &chart = charts.write[sorted_chart.index];
+		Size2i padded_size = chart.image->get_size() + Size2i(p_padding, p_padding);
+		ERR_CONTINUE_MSG(padded_size.width > page_width || padded_size.height > p_max_page_size, "Texture chart is larger than the maximum atlas page size.");
+
+		Point2i position;
+		for (uint32_t page = 0; page < packers.size(); page++) {
+			if (packers[page].insert(padded_size, position)) {
+				chart.page = page;
+				break;
+			}
+		}
+		if (chart.page < 0) {
+			packers.push_back(TRSkylinePacker(Size2i(page_width, p_max_page_size)));
+			packers[packers.size() - 1].insert(padded_size, position);
+			chart.page = packers.size() - 1;
+		}
+		chart.position = position + Point2i(p_padding / 2, p_padding / 2);
+	}
 
-		new_atlas->blit_rect(src_texture, src_rect, current_position);
+	// A texture array needs every layer at the same size.
+	int32_t uniform_page_height = 1;
+	for (const TRSkylinePacker &packer : packers) {
+		uniform_page_height = MAX(uniform_page_height, int32_t(next_power_of_2(uint32_t(packer.get_used_height()))));
+	}
 
-		add_pixel_padding(new_atlas, src_texture, src_rect, current_position, PADDING_PIXELS);
+	for (const TRSkylinePacker &packer : packers) {
+		int32_t page_height = p_uniform_page_size ? uniform_page_height : next_power_of_2(uint32_t(MAX(packer.get_used_height(), 1)));
+		result.pages.push_back(memnew(Image(page_width, page_height, false, Image::FORMAT_RGBA8)));
+	}
 
-		current_position.x += src_rect.size.x + PADDING_PIXELS;
-		max_row_height = MAX(max_row_height, src_rect.size.y);
+	result.page_charts.resize(result.pages.size());
+	for (const TRLevelAtlasChart &chart : charts) {
+		if (chart.page < 0) {
+			continue;
+		}
+		Rect2i src_rect = Rect2i(Point2i(), chart.image->get_size());
+		result.page_charts.write[chart.page].push_back(Rect2i(chart.position, src_rect.size).grow(p_padding / 2));
+		copy_rgba8_chart(result.pages[chart.page], chart.position, chart.image, src_rect, p_padding / 2);
 	}
 
-	PackedByteArray pba = new_atlas->get_data();
+	// Corners on the far edge of a region map to the far edge of its chart, matching the
+	// stretch the original 0..255 UV mapping applied within a page.
+	result.texture_info_remaps.resize(p_texture_infos.size());
+	for (int32_t i = 0; i < p_texture_infos.size(); i++) {
+		int32_t chart_index = texture_info_charts[i];
+		if (chart_index < 0 || charts[chart_index].page < 0) {
+			continue;
+		}
 
-	result.custom_atlases.push_back(new_atlas);
+		const TRLevelAtlasChart &chart = charts[chart_index];
+		const Rect2i &rect = texture_info_rects[i];
+		Vector2 page_size = result.pages[chart.page]->get_size();
+
+		TRTextureInfoRemap &remap = result.texture_info_remaps.write[i];
+		remap.remap_index = chart.page;
+		for (int32_t j = 0; j < corner_counts[i]; j++) {
+			Point2i pixel = Point2i(p_texture_infos[i].uv[j].u >> 8, p_texture_infos[i].uv[j].v >> 8) - rect.position;
+			Vector2 chart_uv = Vector2(
+				real_t(pixel.x) * rect.size.width / MAX(rect.size.width - 1, 1),
+				real_t(pixel.y) * rect.size.height / MAX(rect.size.height - 1, 1));
+			remap.uv[j] = (Vector2(chart.position) + chart_uv) / page_size;
+		}
+	}
 
-	String test_atlas_path = String("test_atlas") + String(".png");
-	new_atlas->save_png(test_atlas_path);
+	return result;
 }
 
-struct TRTextureInfoRemap {
-	int32_t remap_index = -1;
-	Vector2 uv[4];
-};
-
 void remap_room_textures(
 	const Vector<TRRoom> p_rooms,
 	const Vector<Ref<Image>> p_images,
@@ -3940,48 +5619,35 @@ void remap_room_textures(
 	const HashMap<String, String> p_room_name_table) {
 	
 	// Room Texture Remapping
-	Vector<uint32_t> valid_room_texture_quad_ids;
-	Vector<uint32_t> valid_room_texture_triangle_ids;
+	TRTextureInfoIdSet valid_room_texture_quad_ids;
+	TRTextureInfoIdSet valid_room_texture_triangle_ids;
 
 	Vector2i largest_room_texture_chart = Vector2i(0, 0);
 
 	for (const TRRoom& room : p_rooms) {
 		for (int32_t i = 0; i < room.data.room_quad_count; i++) {
-			if (room.data.room_quads[i].tex_info_id < 0) {
-				continue;
-			}
-
-			if (!valid_room_texture_quad_ids.has(room.data.room_quads[i].tex_info_id)) {
-				valid_room_texture_quad_ids.push_back(room.data.room_quads[i].tex_info_id);
-			}
+			valid_room_texture_quad_ids.insert(room.data.room_quads[i].tex_info_id);
 		}
 
 		for (int32_t i = 0; i < room.data.room_triangle_count; i++) {
-			if (room.data.room_triangles[i].tex_info_id < 0) {
-				continue;
-			}
-
-			if (!valid_room_texture_triangle_ids.has(room.data.room_triangles[i].tex_info_id)) {
-				valid_room_texture_triangle_ids.push_back(room.data.room_triangles[i].tex_info_id);
-			}
+			valid_room_texture_triangle_ids.insert(room.data.room_triangles[i].tex_info_id);
 		}
 	}
 
 	Vector<TRTexturePageAtlas> atlases;
 	atlases.resize(p_images.size());
+	Vector<HashSet<Rect2i>> atlas_charts;
+	atlas_charts.resize(p_images.size());
 
 	// Get all the quad-based textures.
-	uint32_t index = 0;
-	for (const uint32_t& id : valid_room_texture_quad_ids) {
-		if (id >= p_texture_infos.size()) {
-			index++;
+	for (uint32_t id = 0; id < uint32_t(p_texture_infos.size()); id++) {
+		if (!valid_room_texture_quad_ids.has(id)) {
 			continue;
 		}
 
-		TRTextureInfo texture_info = p_texture_infos.get(id);
+		const TRTextureInfo &texture_info = p_texture_infos[id];
 
 		if (texture_info.texture_page >= p_images.size()) {
-			index++;
 			continue;
 		}
 
@@ -3999,22 +5665,21 @@ void remap_room_textures(
 			largest_room_texture_chart.y = texture_rect.size.y;
 		}
 
-		TRTexturePageAtlas atlas = atlases.get(texture_info.texture_page);
-		atlas.used_charts.append(texture_rect);
-		atlases.set(texture_info.texture_page, atlas);
+		if (!atlas_charts[texture_info.texture_page].has(texture_rect)) {
+			atlas_charts.write[texture_info.texture_page].insert(texture_rect);
+			atlases.write[texture_info.texture_page].used_charts.push_back(texture_rect);
+		}
 	}
 
 	// Get all the triangle-based textures.
-	for (const uint32_t& id : valid_room_texture_triangle_ids) {
-		if (id >= p_texture_infos.size()) {
-			index++;
+	for (uint32_t id = 0; id < uint32_t(p_texture_infos.size()); id++) {
+		if (!valid_room_texture_triangle_ids.has(id)) {
 			continue;
 		}
 
-		TRTextureInfo texture_info = p_texture_infos.get(id);
+		const TRTextureInfo &texture_info = p_texture_infos[id];
 
 		if (texture_info.texture_page >= p_images.size()) {
-			index++;
 			continue;
 		}
 
@@ -4023,9 +5688,10 @@ void remap_room_textures(
 		texture_rect.expand_to(Point2i(texture_info.uv[1].u, texture_info.uv[1].v));
 		texture_rect.expand_to(Point2i(texture_info.uv[2].u, texture_info.uv[2].v));
 
-		TRTexturePageAtlas atlas = atlases.get(texture_info.texture_page);
-		atlas.used_charts.append(texture_rect);
-		atlases.set(texture_info.texture_page, atlas);
+		if (!atlas_charts[texture_info.texture_page].has(texture_rect)) {
+			atlas_charts.write[texture_info.texture_page].insert(texture_rect);
+			atlases.write[texture_info.texture_page].used_charts.push_back(texture_rect);
+		}
 	}
 
 	Vector<TRTexturePageAtlas> filtered_atlases;
@@ -4045,9 +5711,7 @@ void remap_room_textures(
 			}
 
 			if (!skip) {
-				TRTexturePageAtlas atlas = filtered_atlases.get(i);
-				atlas.used_charts.append(chart);
-				filtered_atlases.set(i, atlas);
+				filtered_atlases.write[i].used_charts.push_back(chart);
 			}
 
 			// TODO: super aggressive sub-chart detection
@@ -4071,7 +5735,10 @@ void remap_room_textures(
 			size_corrected_chart.size.width = int32_t(round(width));
 			size_corrected_chart.size.height = int32_t(round(height));
 
-			Ref<Image> image_region = image_texture->get_region(size_corrected_chart);
+			Ref<Image> image_region = extract_rgba8_chart(image_texture, size_corrected_chart);
+			if (image_region.is_null()) {
+				continue;
+			}
 
 			HashingContext hashing_context;
 
@@ -4131,61 +5798,133 @@ void remap_room_textures(
 	}
 }
 
-Ref<Shader> generate_shader(bool p_transparent, int32_t p_stencil) {
-	Ref<Shader> shader = memnew(Shader);
-	String shader_code = "";
+// How the pages of shared meshes become materials, matching the level's own pages.
+struct TRSharedMeshMaterialOptions {
+	// Generic materials are used without shaders.
+	Ref<Shader> solid_shader;
+	Ref<Shader> transparent_shader;
+	// Set when pages hold palette indices.
+	Ref<Texture> palette_texture;
+	bool mipmaps = false;
+	TRTextureCompression compression = TR_TEXTURE_COMPRESSION_NONE;
+};
 
-	shader_code = "shader_type spatial;\n";
-	if (p_stencil >= 0) {
-		shader_code += "render_mode blend_mix, depth_draw_always, cull_back, diffuse_burley, specular_schlick_ggx, ambient_light_disabled;\n";
-		shader_code += "stencil_mode read, compare_equal, " + itos(p_stencil) + ";\n\n";
-	} else {
-		shader_code += "render_mode blend_mix, depth_draw_opaque, cull_back, diffuse_burley, specular_schlick_ggx, ambient_light_disabled;\n\n";
-	}
-	shader_code += "uniform sampler2D texture_albedo : source_color, filter_nearest, repeat_disable;\n\n";
-	shader_code += 
-			"void fragment() {\n\
-			vec2 base_uv = UV;\n\
-			vec4 albedo_tex = texture(texture_albedo, base_uv);\n\
-			ALBEDO = vec3(0.0, 0.0, 0.0);\n\
-			float inv_gamma =  1.0 / 2.2;\n\
-			float gamma = 2.2;\n\
-			vec3 color_gamma = pow(albedo_tex.rgb, vec3(inv_gamma, inv_gamma, inv_gamma));\n\
-			color_gamma *= COLOR.rgb;\n\
-			color_gamma *= 2.0;\n\
-			EMISSION.rgb = pow(color_gamma, vec3(gamma, gamma, gamma));\n\
-			METALLIC = 0.0;\n\
-			SPECULAR = 1.0;\n\
-			ROUGHNESS = 1.0;\n";
-	if (p_transparent) {
-		shader_code += 
-			"\t\tALPHA = albedo_tex.a;\n";
-		if (p_stencil < 0) {
-			shader_code +=
-				"\t\tALPHA_SCISSOR_THRESHOLD = 1.0;\n";
+// Builds a mesh which samples pages of its own instead of the level's. The charts its
+// faces use are packed the way the level atlas packs a level, so the mesh, its pages and
+// its materials only depend on the mesh's content (see get_tr_mesh_content_hash), and
+// every level containing it can reference the one cached resource.
+Ref<ArrayMesh> tr_mesh_to_shared_godot_mesh(
+	const TRMesh &p_mesh_data,
+	const Vector<TRTextureInfo> &p_texture_infos,
+	const Vector<Ref<Image>> &p_pages,
+	const Ref<Material> &p_palette_material,
+	const TRSharedMeshMaterialOptions &p_options) {
+	Vector<TRMesh> meshes;
+	meshes.push_back(p_mesh_data);
+	TRLevelTextureAtlas mesh_pages = pack_level_texture_atlas(Vector<TRRoom>(), meshes, p_texture_infos, p_pages);
+
+	Vector<Ref<Material>> solid_materials;
+	Vector<Ref<Material>> transparent_materials;
+	for (int32_t i = 0; i < mesh_pages.pages.size(); i++) {
+		Ref<Image> page = mesh_pages.pages[i];
+		if (p_options.palette_texture.is_valid()) {
+			page->convert(Image::FORMAT_R8);
+		} else {
+			if (p_options.mipmaps) {
+				page = generate_tr_chart_mipmaps(page, mesh_pages.page_charts[i]);
+			}
+			if (p_options.compression != TR_TEXTURE_COMPRESSION_NONE) {
+				page = compress_tr_texture_image(page, p_options.compression, false);
+			}
 		}
-	} else {
-		if (p_stencil >= 0) {
-			shader_code +=
-				"\t\tALPHA = 1.0;\n";
+
+		Ref<ImageTexture> texture = ImageTexture::create_from_image(page);
+		if (p_options.solid_shader.is_valid()) {
+			Ref<ShaderMaterial> solid_material = generate_tr_godot_shader_material(texture, p_options.solid_shader);
+			Ref<ShaderMaterial> transparent_material = generate_tr_godot_shader_material(texture, p_options.transparent_shader);
+			if (p_options.palette_texture.is_valid()) {
+				solid_material->set_shader_parameter("palette_texture", p_options.palette_texture);
+				transparent_material->set_shader_parameter("palette_texture", p_options.palette_texture);
+			}
+			solid_materials.push_back(solid_material);
+			transparent_materials.push_back(transparent_material);
+		} else {
+			solid_materials.push_back(generate_tr_godot_generic_material(texture, false, p_options.mipmaps));
+			transparent_materials.push_back(generate_tr_godot_generic_material(texture, true, p_options.mipmaps));
 		}
 	}
-	shader_code += "}";
 
-	shader->set_code(shader_code);
+	return tr_mesh_to_godot_mesh(p_mesh_data, solid_materials, transparent_materials, p_palette_material, p_texture_infos, mesh_pages.texture_info_remaps);
+}
 
-	return shader;
+// Expands a texture page to RGBA8. Index 0 of 8-bit pages is transparent.
+Ref<Image> tr_texture_page_to_image(const PackedByteArray &p_texture, TRTextureType p_texture_type, const Vector<TRColor3> &p_palette) {
+	Ref<Image> image = memnew(Image(TR_TEXTILE_SIZE, TR_TEXTILE_SIZE, false, Image::FORMAT_RGBA8));
+	if (p_texture_type == TR_TEXTURE_TYPE_8_PAL) {
+		for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
+			for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
+				uint8_t index = p_texture.get((y * TR_TEXTILE_SIZE) + x);
+
+				if (index == 0x00) {
+					TRColor3 color = p_palette.get(index);
+					image->set_pixel(x, y, Color(0.0f, 0.0f, 0.0f, 0.0f));
+				}
+				else {
+					TRColor3 color = p_palette.get(index);
+					image->set_pixel(x, y, Color(((float)color.r / 255.0f), ((float)color.g / 255.0f), ((float)color.b / 255.0f), 1.0f));
+				}
+			}
+		}
+	} else if (p_texture_type == TR_TEXTURE_TYPE_16) {
+		for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
+			for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
+				uint32_t index = ((y * TR_TEXTILE_SIZE) + x) * sizeof(uint16_t);
+				uint16_t pixel = p_texture.get(index + 0) | (uint16_t)p_texture.get(index + 1) << 8;
+
+				image->set_pixel(x, y, Color(
+					((float)((pixel & 0x7c00) >> 10) / 31.0f),
+					((float)((pixel & 0x03e0) >> 5) / 31.0f),
+					((float)((pixel & 0x001f)) / 31.0f),
+					((float)((pixel & 0x8000) >> 15) / 1.0f)
+				));
+			}
+		}
+	} else if (p_texture_type == TR_TEXTURE_TYPE_32) {
+		for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
+			for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
+				uint32_t index = ((y * TR_TEXTILE_SIZE) + x) * sizeof(uint32_t);
+				uint8_t b = p_texture.get(index + 0);
+				uint8_t g = p_texture.get(index + 1);
+				uint8_t r = p_texture.get(index + 2);
+				uint8_t a = p_texture.get(index + 3);
+
+				image->set_pixel(x, y, Color(((float)r / 255.0f), ((float)g / 255.0f), ((float)b / 255.0f), a / 255.0f));
+			}
+		}
+	}
+
+	return image;
 }
 
 Node3D *generate_godot_scene(
 	Node *p_root,
 	Ref<TRLevelData> p_level_data,
-	bool p_lara_only) {
+	bool p_lara_only,
+	bool p_use_resource_cache,
+	const TRSceneOptions &p_options,
+	TRLoadProgress *p_progress = nullptr,
+	TRLoadStatistics *p_statistics = nullptr) {
+	TR_SCOPED_TIMER(p_statistics, "generate_godot_scene");
 
 	ERR_FAIL_COND_V(p_level_data.is_null(), nullptr);
 
-	Ref<Shader> level_solid_shader = generate_shader(false, -1);
-	Ref<Shader> level_transparent_shader = generate_shader(true, -1);
+	// 8-bit palette levels can keep their pages as indices and resolve colours in the shaders.
+	bool use_palette_textures = p_options.use_palette_textures && p_level_data->texture_type == TR_TEXTURE_TYPE_8_PAL && !p_level_data->palette.is_empty();
+	if (use_palette_textures && (p_options.generate_mipmaps || p_options.texture_compression != TR_TEXTURE_COMPRESSION_NONE)) {
+		WARN_PRINT("Palette index textures can't be mipmapped or compressed, ignoring those options.");
+	}
+	bool generate_mipmaps = p_options.generate_mipmaps && !use_palette_textures;
+	bool use_room_light_list = p_options.room_lighting == TR_ROOM_LIGHTING_LIGHT_LIST && !p_lara_only;
 
 	Ref<Material> palette_material;
 	
@@ -4201,7 +5940,11 @@ Node3D *generate_godot_scene(
 			}
 		}
 		Ref<ImageTexture> it = ImageTexture::create_from_image(palette_image);
-		palette_material = generate_tr_godot_generic_material(it, false);
+		if (use_room_light_list) {
+			palette_material = generate_tr_godot_shader_material(it, generate_entity_shader(false, false, true));
+		} else {
+			palette_material = generate_tr_godot_generic_material(it, false);
+		}
 
 		String palette_path = String("Pal") + String(".png");
 		palette_image->save_png(palette_path);
@@ -4210,132 +5953,257 @@ Node3D *generate_godot_scene(
 	Vector<Ref<Image>> images;
 	Vector<Ref<ImageTexture>> image_textures;
 
-	for (int32_t i = 0; i < p_level_data->level_textures.size(); i++) {
-		PackedByteArray current_texture = p_level_data->level_textures.get(i);
-		Ref<Image> image = memnew(Image(TR_TEXTILE_SIZE, TR_TEXTILE_SIZE, false, Image::FORMAT_RGBA8));
-		if (p_level_data->texture_type == TR_TEXTURE_TYPE_8_PAL) {
-			for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
-				for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
-					uint8_t index = current_texture.get((y * TR_TEXTILE_SIZE) + x);
-
-					if (index == 0x00) {
-						TRColor3 color = p_level_data->palette.get(index);
-						image->set_pixel(x, y, Color(0.0f, 0.0f, 0.0f, 0.0f));
-					}
-					else {
-						TRColor3 color = p_level_data->palette.get(index);
-						image->set_pixel(x, y, Color(((float)color.r / 255.0f), ((float)color.g / 255.0f), ((float)color.b / 255.0f), 1.0f));
-					}
+	// Palette pages stay indices until something needs their colours, which
+	// is only the room texture remap below.
+	TRScopedTimer texture_conversion_timer(p_statistics, "texture_conversion");
+	Vector<PackedByteArray> texture_pages = p_level_data->level_textures;
+	texture_pages.append_array(p_level_data->entity_textures);
+	if (!use_palette_textures) {
+		for (int32_t i = 0; i < texture_pages.size(); i++) {
+			if (p_progress) {
+				if (p_progress->is_cancelled()) {
+					return nullptr;
 				}
+				p_progress->report(TR_LOAD_PHASE_TEXTURES, i, texture_pages.size());
 			}
-		} else if (p_level_data->texture_type == TR_TEXTURE_TYPE_16) {
-			for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
-				for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
-					uint32_t index = ((y * TR_TEXTILE_SIZE) + x) * sizeof(uint16_t);
-					uint16_t pixel = current_texture.get(index + 0) | (uint16_t)current_texture.get(index + 1) << 8;
-
-					image->set_pixel(x, y, Color(
-						((float)((pixel & 0x7c00) >> 10) / 31.0f),
-						((float)((pixel & 0x03e0) >> 5) / 31.0f),
-						((float)((pixel & 0x001f)) / 31.0f),
-						((float)((pixel & 0x8000) >> 15) / 1.0f)
-					));
-				}
+
+			Ref<Image> image = tr_texture_page_to_image(texture_pages[i], p_level_data->texture_type, p_level_data->palette);
+			images.push_back(image);
+			image_textures.push_back(ImageTexture::create_from_image(image));
+		}
+	}
+
+	texture_conversion_timer.stop();
+
+	TRGodotMaterialTable material_table;
+
+	// The original pages stay in images, since the room texture remap still reads from them.
+	Vector<Ref<Image>> material_images = images;
+	Vector<Vector<Rect2i>> material_page_charts;
+
+	Ref<ImageTexture> palette_texture;
+	if (use_palette_textures) {
+		Ref<Image> palette_strip_image = memnew(Image(256, 1, false, Image::FORMAT_RGBA8));
+		for (int32_t i = 0; i < 256 && i < p_level_data->palette.size(); i++) {
+			TRColor3 color = p_level_data->palette[i];
+			palette_strip_image->set_pixel(i, 0, Color(((float)color.r / 255.0f), ((float)color.g / 255.0f), ((float)color.b / 255.0f), i == 0 ? 0.0f : 1.0f));
+		}
+		palette_texture = ImageTexture::create_from_image(palette_strip_image);
+
+		// Indices ride in the red channel of RGBA8 pages until the atlas step is done,
+		// so the packer and its chart helpers need no separate single-channel path.
+		material_images.clear();
+		for (const PackedByteArray &index_page : texture_pages) {
+			PackedByteArray data;
+			data.resize(TR_TEXTILE_SIZE * TR_TEXTILE_SIZE * 4);
+			uint8_t *dst = data.ptrw();
+			for (int32_t i = 0; i < TR_TEXTILE_SIZE * TR_TEXTILE_SIZE; i++) {
+				dst[i * 4 + 0] = i < index_page.size() ? index_page[i] : 0;
+				dst[i * 4 + 1] = 0;
+				dst[i * 4 + 2] = 0;
+				dst[i * 4 + 3] = 255;
 			}
-		} else if (p_level_data->texture_type == TR_TEXTURE_TYPE_32) {
-			for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
-				for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
-					uint32_t index = ((y * TR_TEXTILE_SIZE) + x) * sizeof(uint32_t);
-					uint8_t b = current_texture.get(index + 0);
-					uint8_t g = current_texture.get(index + 1);
-					uint8_t r = current_texture.get(index + 2);
-					uint8_t a = current_texture.get(index + 3);
+			material_images.push_back(Image::create_from_data(TR_TEXTILE_SIZE, TR_TEXTILE_SIZE, false, Image::FORMAT_RGBA8, data));
+		}
+	}
 
-					image->set_pixel(x, y, Color(((float)r / 255.0f), ((float)g / 255.0f), ((float)b / 255.0f), a / 255.0f));
+	// Shared meshes cut their own pages out of these, before the level atlas repacks them.
+	Vector<Ref<Image>> shared_mesh_source_pages = material_images;
+
+	if (p_options.use_texture_atlas && !material_images.is_empty()) {
+		TR_SCOPED_TIMER(p_statistics, "texture_atlas");
+
+		TRLevelTextureAtlas atlas = pack_level_texture_atlas(
+			p_level_data->rooms,
+			p_level_data->types.meshes,
+			p_level_data->types.texture_infos,
+			material_images,
+			2048,
+			4,
+			p_options.use_texture_array);
+
+		if (!atlas.pages.is_empty()) {
+			material_images = atlas.pages;
+			material_page_charts = atlas.page_charts;
+			material_table.texture_info_remaps = atlas.texture_info_remaps;
+
+			// Palette pages get their textures once they are converted to R8 below.
+			image_textures.clear();
+			if (!use_palette_textures) {
+				for (const Ref<Image> &page : atlas.pages) {
+					image_textures.push_back(ImageTexture::create_from_image(page));
 				}
 			}
 		}
+	}
 
-#if 0
-		String image_path = String("LevelTexture_") + itos(i) + String(".png");
-		image->save_png(image_path);
-#endif
+	if (use_palette_textures) {
+		image_textures.clear();
+		for (int32_t i = 0; i < material_images.size(); i++) {
+			// Converted on a copy, since without an atlas these are still the shared mesh source pages.
+			Ref<Image> index_page = material_images[i]->duplicate();
+			index_page->convert(Image::FORMAT_R8);
+			material_images.write[i] = index_page;
+			image_textures.push_back(ImageTexture::create_from_image(index_page));
+		}
+	}
+
+	if (generate_mipmaps) {
+		TR_SCOPED_TIMER(p_statistics, "texture_mipmaps");
+
+		if (material_page_charts.is_empty()) {
+			material_page_charts = get_tr_texture_page_charts(p_level_data->types.texture_infos, material_images.size());
+		}
 
-		images.push_back(image);
-		image_textures.push_back(ImageTexture::create_from_image(image));
+		image_textures.clear();
+		for (int32_t i = 0; i < material_images.size(); i++) {
+			material_images.write[i] = generate_tr_chart_mipmaps(material_images[i], material_page_charts[i]);
+			image_textures.push_back(ImageTexture::create_from_image(material_images[i]));
+		}
 	}
 
-	for (int32_t i = 0; i < p_level_data->entity_textures.size(); i++) {
-		PackedByteArray current_texture = p_level_data->entity_textures.get(i);
-		Ref<Image> image = memnew(Image(TR_TEXTILE_SIZE, TR_TEXTILE_SIZE, false, Image::FORMAT_RGBA8));
-		if (p_level_data->texture_type == TR_TEXTURE_TYPE_8_PAL) {
-			for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
-				for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
-					uint8_t index = current_texture.get((y * TR_TEXTILE_SIZE) + x);
-
-					if (index == 0x00) {
-						TRColor3 color = p_level_data->palette.get(index);
-						image->set_pixel(x, y, Color(0.0f, 0.0f, 0.0f, 0.0f));
-					}
-					else {
-						TRColor3 color = p_level_data->palette.get(index);
-						image->set_pixel(x, y, Color(((float)color.r / 255.0f), ((float)color.g / 255.0f), ((float)color.b / 255.0f), 1.0f));
-					}
-				}
+	if (p_options.texture_compression != TR_TEXTURE_COMPRESSION_NONE && !use_palette_textures) {
+		TR_SCOPED_TIMER(p_statistics, "texture_compression");
+
+		// Compressed pages are stored in the resource cache so later imports skip the compressor.
+		// The compressed Image is cached alongside its texture, since reading it back from the
+		// texture may hand back a decompressed copy (or nothing) instead of the compressed data.
+		TRResourceCache *texture_cache = p_use_resource_cache ? TRResourceCache::get_singleton() : nullptr;
+
+		image_textures.clear();
+		for (int32_t i = 0; i < material_images.size(); i++) {
+			String texture_key;
+			String texture_image_key;
+			Ref<Image> compressed_image;
+			if (texture_cache) {
+				TRContentHasher hasher;
+				hasher.put_u32(p_options.texture_compression);
+				hasher.put_u8(p_options.use_texture_array);
+				hasher.put_u32(material_images[i]->get_width());
+				hasher.put_u32(material_images[i]->get_height());
+				hasher.put_data(material_images[i]->get_data());
+				String texture_hash = hasher.finish();
+				texture_key = "texture_" + texture_hash;
+				texture_image_key = "texture_image_" + texture_hash;
+
+				compressed_image = texture_cache->get_resource(texture_image_key);
 			}
-		} else if (p_level_data->texture_type == TR_TEXTURE_TYPE_16) {
-			for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
-				for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
-					uint32_t index = ((y * TR_TEXTILE_SIZE) + x) * sizeof(uint16_t);
-					uint16_t pixel = current_texture.get(index + 0) | (uint16_t) current_texture.get(index + 1) << 8;
-
-					image->set_pixel(x, y, Color(
-						((float)((pixel & 0x7c00) >> 10) / 31.0f),
-						((float)((pixel & 0x03e0) >> 5) / 31.0f),
-						((float)((pixel & 0x001f)) / 31.0f),
-						((float)((pixel & 0x8000) >> 15) / 1.0f)
-					));
+
+			if (compressed_image.is_null()) {
+				compressed_image = compress_tr_texture_image(material_images[i], p_options.texture_compression, p_options.use_texture_array);
+				if (texture_cache) {
+					compressed_image = texture_cache->store_resource(texture_image_key, compressed_image);
 				}
 			}
-		} else if (p_level_data->texture_type == TR_TEXTURE_TYPE_32) {
-			for (int32_t x = 0; x < TR_TEXTILE_SIZE; x++) {
-				for (int32_t y = 0; y < TR_TEXTILE_SIZE; y++) {
-					uint32_t index = ((y * TR_TEXTILE_SIZE) + x) * sizeof(uint32_t);
-					uint8_t b = current_texture.get(index + 0);
-					uint8_t g = current_texture.get(index + 1);
-					uint8_t r = current_texture.get(index + 2);
-					uint8_t a = current_texture.get(index + 3);
 
-					image->set_pixel(x, y, Color(((float)r / 255.0f), ((float)g / 255.0f), ((float)b / 255.0f), a / 255.0f));
+			Ref<ImageTexture> texture;
+			if (texture_cache) {
+				texture = texture_cache->get_resource(texture_key);
+			}
+			if (texture.is_null()) {
+				texture = ImageTexture::create_from_image(compressed_image);
+				if (texture_cache) {
+					texture = texture_cache->store_resource(texture_key, texture);
 				}
 			}
-		}
-
-#if 0
-		String image_path = String("EntityTexture_") + itos(i) + String(".png");
-		image->save_png(image_path);
-#endif
 
-		images.push_back(image);
-		image_textures.push_back(ImageTexture::create_from_image(image));
+			material_images.write[i] = compressed_image;
+			image_textures.push_back(texture);
+		}
 	}
 
-	TRGodotMaterialTable material_table;
+	Vector<Ref<Texture>> page_textures;
+	bool use_entity_shader = use_palette_textures || use_room_light_list;
+	Ref<Shader> entity_solid_shader;
+	Ref<Shader> entity_transparent_shader;
+	if (use_entity_shader) {
+		entity_solid_shader = generate_entity_shader(false, use_palette_textures, use_room_light_list, generate_mipmaps);
+		entity_transparent_shader = generate_entity_shader(true, use_palette_textures, use_room_light_list, generate_mipmaps);
+	}
 
 	for (int32_t i = 0; i < image_textures.size(); i++) {
-		material_table.materials.level_solid_materials.append(generate_tr_godot_shader_material(image_textures[i], level_solid_shader));
-		material_table.materials.level_transparent_materials.append(generate_tr_godot_shader_material(image_textures[i], level_transparent_shader));
-		material_table.materials.entity_solid_materials.append(generate_tr_godot_generic_material(image_textures[i], false));
-		material_table.materials.entity_transparent_materials.append(generate_tr_godot_generic_material(image_textures[i], true));
+		page_textures.push_back(image_textures[i]);
+		if (use_entity_shader) {
+			Ref<ShaderMaterial> solid_material = generate_tr_godot_shader_material(image_textures[i], entity_solid_shader);
+			Ref<ShaderMaterial> transparent_material = generate_tr_godot_shader_material(image_textures[i], entity_transparent_shader);
+			if (use_palette_textures) {
+				solid_material->set_shader_parameter("palette_texture", palette_texture);
+				transparent_material->set_shader_parameter("palette_texture", palette_texture);
+			}
+			material_table.materials.entity_solid_materials.append(solid_material);
+			material_table.materials.entity_transparent_materials.append(transparent_material);
+		} else {
+			material_table.materials.entity_solid_materials.append(generate_tr_godot_generic_material(image_textures[i], false, generate_mipmaps));
+			material_table.materials.entity_transparent_materials.append(generate_tr_godot_generic_material(image_textures[i], true, generate_mipmaps));
+		}
+	}
+	material_table.room_materials.set_page_textures(page_textures);
+	material_table.room_materials.set_palette_texture(palette_texture);
+	material_table.room_materials.set_mipmaps(generate_mipmaps);
+
+	if (p_options.use_texture_array && !material_images.is_empty()) {
+		Ref<Texture2DArray> texture_array;
+		texture_array.instantiate();
+		if (texture_array->create_from_images(material_images) == OK) {
+			material_table.room_materials.set_array_texture(texture_array);
+		} else {
+			ERR_PRINT("Could not create the level texture array, falling back to one material per texture page.");
+		}
 	}
 
 
+	// Cached meshes sample pages of their own rather than the level's (or its atlas),
+	// so every level containing one references the same resource.
+	TRResourceCache *resource_cache = p_use_resource_cache ? TRResourceCache::get_singleton() : nullptr;
+
+	TRSharedMeshMaterialOptions shared_mesh_material_options;
+	shared_mesh_material_options.solid_shader = entity_solid_shader;
+	shared_mesh_material_options.transparent_shader = entity_transparent_shader;
+	shared_mesh_material_options.palette_texture = palette_texture;
+	shared_mesh_material_options.mipmaps = generate_mipmaps;
+	shared_mesh_material_options.compression = use_palette_textures ? TR_TEXTURE_COMPRESSION_NONE : p_options.texture_compression;
+
+	// Cached meshes carry their materials, so texture options that change them are part of the key.
+	String mesh_material_variant;
+	if (use_palette_textures) {
+		mesh_material_variant += "palette_";
+	}
+	if (generate_mipmaps) {
+		mesh_material_variant += "mipmaps_";
+	}
+	if (use_room_light_list) {
+		mesh_material_variant += "light_list_";
+	}
+	if (p_options.texture_compression != TR_TEXTURE_COMPRESSION_NONE && !use_palette_textures) {
+		mesh_material_variant += "compression" + itos(p_options.texture_compression) + "_";
+	}
+
+	TRScopedTimer mesh_build_timer(p_statistics, "mesh_build");
 	Vector<Ref<ArrayMesh>> meshes;
 	for (TRMesh& tr_mesh : p_level_data->types.meshes) {
-		Ref<ArrayMesh> mesh = tr_mesh_to_godot_mesh(tr_mesh, material_table.materials.entity_solid_materials, material_table.materials.entity_transparent_materials, palette_material, p_level_data->types.texture_infos);
-		meshes.push_back(mesh);
+		if (p_progress) {
+			if (p_progress->is_cancelled()) {
+				return nullptr;
+			}
+			p_progress->report(TR_LOAD_PHASE_MESHES, meshes.size(), p_level_data->types.meshes.size());
+		}
+
+		if (resource_cache) {
+			String mesh_key = "mesh_" + mesh_material_variant + get_tr_mesh_content_hash(tr_mesh, p_level_data->types.texture_infos, shared_mesh_source_pages, p_level_data->palette);
+			Ref<ArrayMesh> mesh = resource_cache->get_resource(mesh_key);
+			if (mesh.is_null()) {
+				mesh = resource_cache->store_resource(mesh_key, tr_mesh_to_shared_godot_mesh(tr_mesh, p_level_data->types.texture_infos, shared_mesh_source_pages, palette_material, shared_mesh_material_options));
+			}
+			meshes.push_back(mesh);
+			continue;
+		}
+
+		meshes.push_back(tr_mesh_to_godot_mesh(tr_mesh, material_table.materials.entity_solid_materials, material_table.materials.entity_transparent_materials, palette_material, p_level_data->types.texture_infos, material_table.texture_info_remaps));
 	}
 
+	mesh_build_timer.stop();
+
+	TRScopedTimer audio_decode_timer(p_statistics, "audio_decode");
 	Vector<Ref<AudioStream>> samples;
 
 	// Audio
@@ -4419,6 +6287,8 @@ Node3D *generate_godot_scene(
 		}
 	}
 
+	audio_decode_timer.stop();
+
 	Node *scene_owner = p_root->get_owner() != nullptr ? p_root->get_owner() : p_root;
 
 	if (!p_lara_only) {
@@ -4427,27 +6297,40 @@ Node3D *generate_godot_scene(
 		rooms_node->set_name("TRRooms");
 		rooms_node->set_owner(scene_owner);
 
+		TRScopedTimer moveable_nodes_timer(p_statistics, "moveable_node_creation");
 		Vector<Node3D*> moveable_node = create_godot_nodes_for_moveables(
 			p_level_data->types.moveable_info_map,
 			p_level_data->types,
 			meshes,
 			samples,
 			p_level_data->format,
-			p_level_data->is_using_auxiliary_animation);
+			p_level_data->is_using_auxiliary_animation,
+			p_use_resource_cache,
+			p_progress,
+			p_statistics);
 
 		for (Node3D *moveable : moveable_node) {
 			rooms_node->add_child(moveable);
 			set_owner_recursively(moveable, scene_owner);
 			moveable->set_display_folded(true);
 		}
+		moveable_nodes_timer.stop();
 
 		Node3D *entities_node = memnew(Node3D);
 		p_root->add_child(entities_node);
 		entities_node->set_name("TREntities");
 		entities_node->set_owner(scene_owner);
 
+		TRScopedTimer entity_nodes_timer(p_statistics, "entity_node_creation");
 		uint32_t entity_idx = 0;
 		for (const TREntity& entity : p_level_data->entities) {
+			if (p_progress) {
+				if (p_progress->is_cancelled()) {
+					return nullptr;
+				}
+				p_progress->report(TR_LOAD_PHASE_ANIMATIONS, p_level_data->entities.size() + entity_idx, p_level_data->entities.size() * 2);
+			}
+
 			Node3D *entity_node = memnew(Node3D);
 
 			real_t degrees_rotation = (real_t)((entity.transform.rot.y / 16384.0) * -90.0) + 180.0;
@@ -4472,7 +6355,9 @@ Node3D *generate_godot_scene(
 					p_level_data->format,
 					p_level_data->is_using_auxiliary_animation,
 					false,
-					false);
+					false,
+					p_use_resource_cache,
+					p_statistics);
 				ERR_FAIL_NULL_V(new_node, nullptr);
 				Node3D *type = new_node;
 				entity_node->add_child(type);
@@ -4481,6 +6366,7 @@ Node3D *generate_godot_scene(
 			}
 			entity_idx++;
 		}
+		entity_nodes_timer.stop();
 
 		HashMap<String, String> room_texture_name_table;
 		Ref<ConfigFile> cf;
@@ -4499,13 +6385,56 @@ Node3D *generate_godot_scene(
 				}
 			}
 		}
-		remap_room_textures(p_level_data->rooms, images, p_level_data->types.texture_infos, room_texture_name_table);
+		{
+			TR_SCOPED_TIMER(p_statistics, "room_texture_remap");
+			if (images.is_empty()) {
+				for (const PackedByteArray &texture_page : texture_pages) {
+					images.push_back(tr_texture_page_to_image(texture_page, p_level_data->texture_type, p_level_data->palette));
+				}
+			}
+			remap_room_textures(p_level_data->rooms, images, p_level_data->types.texture_infos, room_texture_name_table);
+		}
 
 		HashMap<int32_t, Vector<TRRoomPortal>> dummy_room_portals;
 
+		Vector<int32_t> room_layers;
+		if (p_options.use_room_stencil_layers) {
+			TR_SCOPED_TIMER(p_statistics, "room_layers");
+			room_layers = get_tr_room_layers(p_level_data->rooms);
+		} else {
+			room_layers.resize(p_level_data->rooms.size());
+			room_layers.fill(0);
+		}
+
+		HashMap<int32_t, TRStaticMeshBatch> level_static_mesh_batches;
+
+		TRScopedTimer rooms_timer(p_statistics, "room_node_creation");
+		Array room_visibility_data;
+		room_visibility_data.resize(p_level_data->rooms.size());
+		Array room_lighting_data;
+		room_lighting_data.resize(p_level_data->rooms.size());
+		Array room_collision_data;
+		room_collision_data.resize(p_level_data->rooms.size());
+
 		uint32_t room_idx = 0;
 		for (const TRRoom& room : p_level_data->rooms) {
-			int32_t current_room_layer = get_room_layer(room_idx);
+			if (p_progress) {
+				if (p_progress->is_cancelled()) {
+					return nullptr;
+				}
+				p_progress->report(TR_LOAD_PHASE_ROOMS, room_idx, p_level_data->rooms.size());
+			}
+
+			int32_t current_room_layer = room_layers[room_idx];
+			room_visibility_data[room_idx] = get_tr_room_visibility_data(room, current_room_layer == 0 ? NodePath(String("../Room_") + itos(room_idx)) : NodePath());
+			room_collision_data[room_idx] = get_tr_room_collision_data(room, p_level_data->floor_data);
+
+			// Room lights are evaluated per entity by TRRoomLighting in the light
+			// list mode, replacing the probe and real-time lights. Entities can
+			// stand in rooms of any layer, so every room gets its light list.
+			if (use_room_light_list) {
+				room_lighting_data[room_idx] = get_tr_room_lighting_data(room);
+			}
 
 			if (current_room_layer == 0) {
 				Node3D* node_3d = memnew(Node3D);
@@ -4532,19 +6461,43 @@ Node3D *generate_godot_scene(
 					node_3d->set_owner(rooms_node->get_owner());
 
 
+					// Static meshes merged into the room geometry share its surfaces.
+					TRRoomData merged_room_data;
+					HashSet<uint32_t> merged_static_meshes;
+					if (p_options.static_mesh_batching == TR_STATIC_MESH_BATCHING_MERGED) {
+						merged_room_data = room.data;
+						for (int32_t static_mesh_idx = 0; static_mesh_idx < room.room_static_meshes.size(); static_mesh_idx++) {
+							const TRRoomStaticMesh &room_static_mesh = room.room_static_meshes[static_mesh_idx];
+							if (!p_level_data->types.static_info_map.has(room_static_mesh.mesh_id)) {
+								continue;
+							}
+
+							TRStaticInfo static_info = p_level_data->types.static_info_map[room_static_mesh.mesh_id];
+							if (!(static_info.flags & 2) || static_info.mesh_number >= p_level_data->types.meshes.size()) {
+								continue;
+							}
+
+							if (append_tr_static_mesh_to_room_data(merged_room_data, p_level_data->types.meshes[static_info.mesh_number], room_static_mesh, room.info)) {
+								merged_static_meshes.insert(static_mesh_idx);
+							}
+						}
+					}
+
 					// Room Mesh
 					MeshInstance3D* mi = memnew(MeshInstance3D);
 					if (mi) {
 						mi->set_name(String("RoomMesh_") + itos(room_idx));
 						node_3d->add_child(mi);
 
+						TRScopedTimer room_mesh_timer(p_statistics, "room_mesh_build");
 						Ref<ArrayMesh> mesh = tr_room_data_to_godot_mesh(
-							room.data,
+							merged_static_meshes.is_empty() ? room.data : merged_room_data,
 							material_table,
 							p_level_data->types,
 							Vector3(-room_offset.x, -room_position.y, room_offset.z),
 							Vector<TRRoomPortal>()
 						);
+						room_mesh_timer.stop();
 
 						mi->set_position(Vector3(0.0, 0.0, 0.0));
 						mi->set_owner(scene_owner);
@@ -4560,128 +6513,132 @@ Node3D *generate_godot_scene(
 						static_body->set_owner(scene_owner);
 						static_body->set_position(Vector3(0.0, 0.0, 0.0));
 
-						CollisionShape3D* collision_shape = tr_room_to_godot_collision_shape(
-							room,
-							p_level_data->floor_data,
-							p_level_data->rooms,
-							Vector3(-room_offset.x, -room_position.y, room_offset.z));
-
-						static_body->add_child(collision_shape);
-						collision_shape->set_owner(scene_owner);
-						collision_shape->set_position(Vector3());
+						TRScopedTimer collision_timer(p_statistics, "collision");
+						if (p_options.room_collision == TR_ROOM_COLLISION_SECTOR_GRID) {
+							Vector<CollisionShape3D *> collision_shapes = tr_room_to_godot_grid_collision_shapes(
+								room,
+								p_level_data->floor_data,
+								p_level_data->rooms,
+								Vector3(-room_offset.x, -room_position.y, room_offset.z));
+							collision_timer.stop();
+
+							for (CollisionShape3D *collision_shape : collision_shapes) {
+								static_body->add_child(collision_shape);
+								collision_shape->set_owner(scene_owner);
+							}
+						} else {
+							CollisionShape3D* collision_shape = tr_room_to_godot_collision_shape(
+								room,
+								p_level_data->floor_data,
+								p_level_data->rooms,
+								Vector3(-room_offset.x, -room_position.y, room_offset.z));
+							collision_timer.stop();
+
+							static_body->add_child(collision_shape);
+							collision_shape->set_owner(scene_owner);
+							collision_shape->set_position(Vector3());
+						}
 					}
 
 					// Static Meshes
+					HashMap<int32_t, TRStaticMeshBatch> room_static_mesh_batches;
 					uint32_t static_mesh_idx = 0;
 					for (const TRRoomStaticMesh& room_static_mesh : room.room_static_meshes) {
 						int32_t mesh_static_number = room_static_mesh.mesh_id;
 
-						if (p_level_data->types.static_info_map.has(mesh_static_number)) {
-							TRStaticInfo static_info = p_level_data->types.static_info_map[mesh_static_number];
-						}
-
-						if (p_level_data->types.static_info_map.has(mesh_static_number)) {
+						if (!merged_static_meshes.has(static_mesh_idx) && p_level_data->types.static_info_map.has(mesh_static_number)) {
 							TRStaticInfo static_info = p_level_data->types.static_info_map[mesh_static_number];
 							if (static_info.flags & 2) {
 								int32_t mesh_number = static_info.mesh_number;
 								if (mesh_number < meshes.size() && mesh_number >= 0) {
-									Ref<ArrayMesh> mesh = meshes.get(mesh_number);
-									MeshInstance3D* mi = memnew(MeshInstance3D);
-									node_3d->add_child(mi);
-									mi->set_mesh(mesh);
-									mi->set_name(String("StaticMeshInstance_") + itos(static_mesh_idx));
-									mi->set_owner(scene_owner);
-									mi->set_transform(node_3d->get_transform().affine_inverse() * Transform3D(Basis().rotated(
-										Vector3(0.0, 1.0, 0.0), Math::deg_to_rad((float)room_static_mesh.rotation / 16384.0f * -90)), Vector3(
-											room_static_mesh.pos.x * TR_TO_GODOT_SCALE,
-											room_static_mesh.pos.y * -TR_TO_GODOT_SCALE,
-											room_static_mesh.pos.z * -TR_TO_GODOT_SCALE)));
-									mi->set_layer_mask(1 << 0);
+									Transform3D static_mesh_transform = get_tr_room_static_mesh_transform(room_static_mesh);
+									// Statics that couldn't be merged fall back to per-room batches.
+									if (p_options.static_mesh_batching == TR_STATIC_MESH_BATCHING_PER_ROOM || p_options.static_mesh_batching == TR_STATIC_MESH_BATCHING_MERGED) {
+										room_static_mesh_batches[mesh_number].add_instance(node_3d->get_transform().affine_inverse() * static_mesh_transform, room_static_mesh);
+									} else if (p_options.static_mesh_batching == TR_STATIC_MESH_BATCHING_GLOBAL) {
+										level_static_mesh_batches[mesh_number].add_instance(static_mesh_transform, room_static_mesh);
+									} else {
+										Ref<ArrayMesh> mesh = meshes.get(mesh_number);
+										MeshInstance3D* mi = memnew(MeshInstance3D);
+										node_3d->add_child(mi);
+										mi->set_mesh(mesh);
+										mi->set_name(String("StaticMeshInstance_") + itos(static_mesh_idx));
+										mi->set_owner(scene_owner);
+										mi->set_transform(node_3d->get_transform().affine_inverse() * static_mesh_transform);
+										mi->set_layer_mask(1 << 0);
+									}
 								}
 							}
 						}
 						static_mesh_idx++;
 					}
 
-					// Room Ambience
-					ReflectionProbe* probe = memnew(ReflectionProbe);
-					if (probe) {
-						probe->set_name("RoomAmbience");
-						probe->set_position(Vector3(0.0, room_offset.y, 0.0));
-						probe->set_size(Vector3(room_size.x, room_size.y + (TR_SQUARE_SIZE * 2.0), room_size.z));
-						probe->set_ambient_color(room.ambient_light);
-						probe->set_ambient_mode(ReflectionProbe::AMBIENT_COLOR);
-						probe->set_as_interior(true);
-						probe->set_cull_mask(0);
-						probe->set_reflection_mask((1 << 1));
-						probe->set_blend_distance(TR_SQUARE_SIZE);
-
-						node_3d->add_child(probe);
-						probe->set_owner(scene_owner);
+					for (const KeyValue<int32_t, TRStaticMeshBatch> &batch : room_static_mesh_batches) {
+						MultiMeshInstance3D *mmi = create_tr_static_mesh_multimesh_instance(meshes.get(batch.key), batch.value);
+						mmi->set_name(String("StaticMultiMesh_") + itos(batch.key));
+						node_3d->add_child(mmi);
+						mmi->set_owner(scene_owner);
 					}
 
-					// Lights
-					int32_t light_idx = 0;
-					for (const TRRoomLight& room_light : room.lights) {
-						OmniLight3D* light_3d = memnew(OmniLight3D);
+					if (!use_room_light_list) {
+						// Room Ambience
+						ReflectionProbe* probe = memnew(ReflectionProbe);
 						if (probe) {
-							light_3d->set_name("RoomLight_" + itos(light_idx));
-
-							Vector3 room_relative_position = Vector3(
-								room_light.pos.x * TR_TO_GODOT_SCALE,
-								room_light.pos.y * -TR_TO_GODOT_SCALE,
-								room_light.pos.z * -TR_TO_GODOT_SCALE
-							) - room_position;
-
-							light_3d->set_cull_mask((1 << 1)); // Dynamic
-							light_3d->set_position(room_relative_position);
-							light_3d->set_color(room_light.color);
-							light_3d->set_param(Light3D::PARAM_RANGE, room_light.range);
-							light_3d->set_param(Light3D::PARAM_ENERGY, room_light.energy);
-							light_3d->set_param(Light3D::PARAM_ATTENUATION, room_light.attenuation);
-
-							node_3d->add_child(light_3d);
-							light_3d->set_owner(scene_owner);
+							probe->set_name("RoomAmbience");
+							probe->set_position(Vector3(0.0, room_offset.y, 0.0));
+							probe->set_size(Vector3(room_size.x, room_size.y + (TR_SQUARE_SIZE * 2.0), room_size.z));
+							probe->set_ambient_color(room.ambient_light);
+							probe->set_ambient_mode(ReflectionProbe::AMBIENT_COLOR);
+							probe->set_as_interior(true);
+							probe->set_cull_mask(0);
+							probe->set_reflection_mask((1 << 1));
+							probe->set_blend_distance(TR_SQUARE_SIZE);
+
+							node_3d->add_child(probe);
+							probe->set_owner(scene_owner);
 						}
 
-						light_idx++;
+						// Lights
+						int32_t light_idx = 0;
+						for (const TRRoomLight& room_light : room.lights) {
+							OmniLight3D* light_3d = memnew(OmniLight3D);
+							if (probe) {
+								light_3d->set_name("RoomLight_" + itos(light_idx));
+
+								Vector3 room_relative_position = Vector3(
+									room_light.pos.x * TR_TO_GODOT_SCALE,
+									room_light.pos.y * -TR_TO_GODOT_SCALE,
+									room_light.pos.z * -TR_TO_GODOT_SCALE
+								) - room_position;
+
+								light_3d->set_cull_mask((1 << 1)); // Dynamic
+								light_3d->set_position(room_relative_position);
+								light_3d->set_color(room_light.color);
+								light_3d->set_param(Light3D::PARAM_RANGE, room_light.range);
+								light_3d->set_param(Light3D::PARAM_ENERGY, room_light.energy);
+								light_3d->set_param(Light3D::PARAM_ATTENUATION, room_light.attenuation);
+
+								node_3d->add_child(light_3d);
+								light_3d->set_owner(scene_owner);
+							}
+
+							light_idx++;
+						}
 					}
 
 					int32_t portal_idx = 0;
 					for (const TRRoomPortal& room_portal : room.portals) {
 						uint32_t adjoining_room = room_portal.adjoining_room;
-						int32_t adjoining_room_layer = get_room_layer(room_portal.adjoining_room);
+						ERR_CONTINUE(room_portal.adjoining_room >= room_layers.size());
+						int32_t adjoining_room_layer = room_layers[room_portal.adjoining_room];
 						if (adjoining_room_layer != current_room_layer) {
 							if (!dummy_room_portals.has(current_room_layer)) {
 								dummy_room_portals[current_room_layer] = Vector<TRRoomPortal>();
 							}
 
-							// Generate stencil versions
-							if (!material_table.read_stencil_materials.has(adjoining_room_layer)) {
-								Ref<Shader> level_solid_shader_read_stencil = generate_shader(false, adjoining_room_layer);
-								Ref<Shader> level_transparent_shader_read_stencil = generate_shader(true, adjoining_room_layer);
+							// Rooms of the adjoining layer now need their stencil-read material variants.
+							material_table.read_stencil_layers.insert(adjoining_room_layer);
 
-								TRGodotMaterials materials;
-								for (const Ref<Material>& material : material_table.materials.level_solid_materials) {
-									Ref<ShaderMaterial> dup_material = material->duplicate();
-									dup_material->set_shader(level_solid_shader_read_stencil);
-									materials.level_solid_materials.append(dup_material);
-								}
-								for (const Ref<Material>& material : material_table.materials.level_transparent_materials) {
-									Ref<ShaderMaterial> dup_material = material->duplicate();
-									dup_material->set_shader(level_transparent_shader_read_stencil);
-									materials.level_transparent_materials.append(dup_material);
-								}
-								for (const Ref<Material>& material : material_table.materials.entity_solid_materials) {
-									Ref<Material> dup_material = material->duplicate();
-									materials.entity_solid_materials.append(dup_material);
-								}
-								for (const Ref<Material>& material : material_table.materials.entity_transparent_materials) {
-									Ref<Material> dup_material = material->duplicate();
-									materials.entity_transparent_materials.append(dup_material);
-								}
-								material_table.read_stencil_materials.insert(adjoining_room_layer, materials);
-							}
 							if (!material_table.portal_stencil_materials.has(adjoining_room_layer)) {
 								Ref<StandardMaterial3D> stencil_material = memnew(StandardMaterial3D);
 
@@ -4731,6 +6688,8 @@ Node3D *generate_godot_scene(
 			Node3D* dummy_node_3d = memnew(Node3D);
 			if (dummy_node_3d) {
 				dummy_node_3d->set_name(String("DummyRoom_") + itos(dummy_room_idx));
+				Dictionary dummy_room_visibility_data = room_visibility_data[dummy_room_idx];
+				dummy_room_visibility_data["node"] = NodePath(String("../DummyRoom_") + itos(dummy_room_idx));
 				dummy_node_3d->set_display_folded(true);
 				rooms_node->add_child(dummy_node_3d);
 
@@ -4776,7 +6735,7 @@ Node3D *generate_godot_scene(
 						p_level_data->types,
 						Vector3(-dummy_room_offset.x, -dummy_room_position.y, dummy_room_offset.z),
 						fixed_room_portals,
-						get_room_layer(dummy_room_idx)
+						room_layers[dummy_room_idx]
 					);
 
 					dummy_mi->set_position(Vector3(0.0, 0.0, 0.0));
@@ -4787,8 +6746,76 @@ Node3D *generate_godot_scene(
 			}
 		}
 
+		// Level-wide batches are drawn regardless of room visibility.
+		for (const KeyValue<int32_t, TRStaticMeshBatch> &batch : level_static_mesh_batches) {
+			MultiMeshInstance3D *mmi = create_tr_static_mesh_multimesh_instance(meshes.get(batch.key), batch.value);
+			mmi->set_name(String("StaticMultiMesh_") + itos(batch.key));
+			rooms_node->add_child(mmi);
+			mmi->set_owner(scene_owner);
+		}
+
+		TRRoomVisibility *room_visibility = memnew(TRRoomVisibility);
+		room_visibility->set_name("TRRoomVisibility");
+		room_visibility->set_rooms(room_visibility_data);
+		rooms_node->add_child(room_visibility);
+		room_visibility->set_owner(scene_owner);
+
+		Array room_activation_paths;
+		for (int32_t i = 0; i < room_visibility_data.size(); i++) {
+			Dictionary room_data = room_visibility_data[i];
+			room_activation_paths.push_back(room_data.get("node", NodePath()));
+		}
+
+		TRRoomActivation *room_activation = memnew(TRRoomActivation);
+		room_activation->set_name("TRRoomActivation");
+		room_activation->set_rooms(room_activation_paths);
+		room_activation->set_room_visibility_path(NodePath("../TRRoomVisibility"));
+		room_activation->set_entity_root_path(NodePath("../../TREntities"));
+		rooms_node->add_child(room_activation);
+		room_activation->set_owner(scene_owner);
+
+		TRLevelCollision *level_collision = memnew(TRLevelCollision);
+		level_collision->set_name("TRLevelCollision");
+		level_collision->set_rooms(room_collision_data);
+		rooms_node->add_child(level_collision);
+		level_collision->set_owner(scene_owner);
+
+		if (use_room_light_list) {
+			TRRoomLighting *room_lighting = memnew(TRRoomLighting);
+			room_lighting->set_name("TRRoomLighting");
+			room_lighting->set_rooms(room_lighting_data);
+			room_lighting->set_room_visibility_path(NodePath("../TRRoomVisibility"));
+			room_lighting->set_lit_root_path(NodePath("../../TREntities"));
+			rooms_node->add_child(room_lighting);
+			room_lighting->set_owner(scene_owner);
+		}
+
+		Array sound_source_data = get_tr_sound_source_data(p_level_data, samples);
+		if (!sound_source_data.is_empty()) {
+			TRSoundSources *sound_sources = memnew(TRSoundSources);
+			sound_sources->set_name("TRSoundSources");
+			sound_sources->set_sources(sound_source_data);
+			sound_sources->set_room_visibility_path(NodePath("../TRRoomVisibility"));
+			rooms_node->add_child(sound_sources);
+			sound_sources->set_owner(scene_owner);
+		}
+
+		rooms_timer.stop();
+
+		if (p_statistics) {
+			p_statistics->set_scene_statistics(get_tr_scene_render_statistics(p_root));
+		}
+
+		if (p_progress) {
+			p_progress->report(TR_LOAD_PHASE_ROOMS, 1.0);
+		}
+
 		return rooms_node;
 	} else {
+		if (p_progress) {
+			p_progress->report(TR_LOAD_PHASE_ANIMATIONS, 0.0);
+		}
+
 		if (p_lara_only) {
 			//Vector<TRMoveableInfo> moveables;
 			//moveables.append(p_level_data->types.moveable_info_map[0]);
@@ -4810,7 +6837,9 @@ Node3D *generate_godot_scene(
 			p_level_data->format,
 			p_level_data->is_using_auxiliary_animation,
 			true,
-			true);
+			true,
+			p_use_resource_cache,
+			p_statistics);
 		ERR_FAIL_COND_V(!new_node, nullptr);
 
 		p_root->add_child(new_node);
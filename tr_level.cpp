@@ -3,6 +3,9 @@
 #include <core/io/stream_peer_gzip.h>
 #include <core/math/math_funcs.h>
 #include <editor/file_system/editor_file_system.h>
+#include <scene/3d/camera_3d.h>
+#include <scene/main/viewport.h>
+#include <servers/rendering_server.h>
 
 #include "tr_level_data.hpp"
 #include "tr_godot_conversion.hpp"
@@ -17,11 +20,66 @@
 
 void TRLevel::_bind_methods() {
 	ClassDB::bind_method("load_level", &TRLevel::load_level);
+	ClassDB::bind_method("load_level_async", &TRLevel::load_level_async);
+	ClassDB::bind_method("cancel_level_load", &TRLevel::cancel_level_load);
+	ClassDB::bind_method("is_loading", &TRLevel::is_loading);
+	ClassDB::bind_method("get_load_statistics", &TRLevel::get_load_statistics);
+	ClassDB::bind_method("start_shader_warmup", &TRLevel::start_shader_warmup);
+	ClassDB::bind_method("is_warming_up_shaders", &TRLevel::is_warming_up_shaders);
 
 	ClassDB::bind_method("set_level_path", &TRLevel::set_level_path);
 	ClassDB::bind_method("get_level_path", &TRLevel::get_level_path);
 
+	ClassDB::bind_method("set_use_resource_cache", &TRLevel::set_use_resource_cache);
+	ClassDB::bind_method("get_use_resource_cache", &TRLevel::get_use_resource_cache);
+
+	ClassDB::bind_method("set_resource_cache_path", &TRLevel::set_resource_cache_path);
+	ClassDB::bind_method("get_resource_cache_path", &TRLevel::get_resource_cache_path);
+
+	ClassDB::bind_method("set_use_texture_array", &TRLevel::set_use_texture_array);
+	ClassDB::bind_method("get_use_texture_array", &TRLevel::get_use_texture_array);
+	ClassDB::bind_method("set_use_texture_atlas", &TRLevel::set_use_texture_atlas);
+	ClassDB::bind_method("get_use_texture_atlas", &TRLevel::get_use_texture_atlas);
+	ClassDB::bind_method("set_generate_mipmaps", &TRLevel::set_generate_mipmaps);
+	ClassDB::bind_method("get_generate_mipmaps", &TRLevel::get_generate_mipmaps);
+	ClassDB::bind_method("set_use_palette_textures", &TRLevel::set_use_palette_textures);
+	ClassDB::bind_method("get_use_palette_textures", &TRLevel::get_use_palette_textures);
+	ClassDB::bind_method("set_texture_compression", &TRLevel::set_texture_compression);
+	ClassDB::bind_method("get_texture_compression", &TRLevel::get_texture_compression);
+
+	ClassDB::bind_method("set_static_mesh_batching", &TRLevel::set_static_mesh_batching);
+	ClassDB::bind_method("get_static_mesh_batching", &TRLevel::get_static_mesh_batching);
+	ClassDB::bind_method("set_room_lighting", &TRLevel::set_room_lighting);
+	ClassDB::bind_method("get_room_lighting", &TRLevel::get_room_lighting);
+	ClassDB::bind_method("set_room_collision", &TRLevel::set_room_collision);
+	ClassDB::bind_method("get_room_collision", &TRLevel::get_room_collision);
+	ClassDB::bind_method("set_use_room_stencil_layers", &TRLevel::set_use_room_stencil_layers);
+	ClassDB::bind_method("get_use_room_stencil_layers", &TRLevel::get_use_room_stencil_layers);
+
+	ClassDB::bind_method("set_warm_up_shaders", &TRLevel::set_warm_up_shaders);
+	ClassDB::bind_method("get_warm_up_shaders", &TRLevel::get_warm_up_shaders);
+
+	ClassDB::bind_method("set_load_trace_path", &TRLevel::set_load_trace_path);
+	ClassDB::bind_method("get_load_trace_path", &TRLevel::get_load_trace_path);
+
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "level_path", PROPERTY_HINT_FILE, "*.phd,*.tr2,*.tr4"), "set_level_path", "get_level_path");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_resource_cache"), "set_use_resource_cache", "get_use_resource_cache");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "resource_cache_path", PROPERTY_HINT_DIR), "set_resource_cache_path", "get_resource_cache_path");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_texture_array"), "set_use_texture_array", "get_use_texture_array");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_texture_atlas"), "set_use_texture_atlas", "get_use_texture_atlas");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "generate_mipmaps"), "set_generate_mipmaps", "get_generate_mipmaps");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_palette_textures"), "set_use_palette_textures", "get_use_palette_textures");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "texture_compression", PROPERTY_HINT_ENUM, "None,S3TC (BC1/BC3),BPTC (BC7),ETC2"), "set_texture_compression", "get_texture_compression");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "static_mesh_batching", PROPERTY_HINT_ENUM, "None,Per Room,Global,Merge Into Room"), "set_static_mesh_batching", "get_static_mesh_batching");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "room_lighting", PROPERTY_HINT_ENUM, "Dynamic Lights,Light List"), "set_room_lighting", "get_room_lighting");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "room_collision", PROPERTY_HINT_ENUM, "Trimesh,Sector Grid"), "set_room_collision", "get_room_collision");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_room_stencil_layers"), "set_use_room_stencil_layers", "get_use_room_stencil_layers");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "warm_up_shaders"), "set_warm_up_shaders", "get_warm_up_shaders");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "load_trace_path", PROPERTY_HINT_SAVE_FILE, "*.json"), "set_load_trace_path", "get_load_trace_path");
+
+	ADD_SIGNAL(MethodInfo("load_progress", PropertyInfo(Variant::STRING, "phase"), PropertyInfo(Variant::FLOAT, "progress")));
+	ADD_SIGNAL(MethodInfo("load_finished", PropertyInfo(Variant::BOOL, "success")));
+	ADD_SIGNAL(MethodInfo("shader_warmup_finished", PropertyInfo(Variant::INT, "material_count")));
 }
 
 TRLevel::TRLevel() {
@@ -29,6 +87,19 @@ TRLevel::TRLevel() {
 }
 
 TRLevel::~TRLevel() {
+	if (load_thread.is_started()) {
+		load_progress.cancelled.set();
+		load_thread.wait_to_finish();
+	}
+
+	if (async_staging_root) {
+		memdelete(async_staging_root);
+		async_staging_root = nullptr;
+	}
+
+	if (shader_warmup_connected) {
+		RenderingServer::get_singleton()->disconnect("frame_post_draw", callable_mp(this, &TRLevel::_shader_warmup_frame));
+	}
 }
 
 TRVertex read_tr_vertex(Ref<TRFileAccess> p_file) {
@@ -1415,24 +1486,344 @@ void TRLevel::clear_level() {
 	}
 }
 
+void TRLevel::_finish_load_statistics() {
+	if (!load_trace_path.is_empty()) {
+		load_statistics.write_chrome_trace(load_trace_path);
+	}
+}
+
 void TRLevel::load_level(bool p_lara_only) {
+	load_statistics.reset();
+
 	Ref<TRLevelData> level_data = load_level_type();
 	if (level_data.is_valid()) {
+		if (use_resource_cache && TRResourceCache::get_singleton()) {
+			TRResourceCache::get_singleton()->set_cache_path(resource_cache_path);
+		}
+
 		Node3D* rooms_node = generate_godot_scene(
 			this,
 			level_data,
-			p_lara_only);
+			p_lara_only,
+			use_resource_cache,
+			scene_options,
+			nullptr,
+			&load_statistics);
 
 		String hd_file_path = level_path.get_basename() + ".TRG";
 		//load_hd_level(hd_file_path);
+
+		if (warm_up_shaders && is_inside_tree()) {
+			start_shader_warmup();
+		}
+	}
+
+	_finish_load_statistics();
+}
+
+// Parsing and scene generation run on a worker thread into a staging node
+// which is not part of the scene tree. Only _finish_async_load touches the tree.
+Error TRLevel::load_level_async(bool p_lara_only) {
+	ERR_FAIL_COND_V_MSG(load_thread.is_started(), ERR_BUSY, "A level is already being loaded.");
+
+	async_lara_only = p_lara_only;
+	async_load_succeeded = false;
+	load_progress.reset(callable_mp(this, &TRLevel::_emit_load_progress));
+	load_statistics.reset();
+
+	if (use_resource_cache && TRResourceCache::get_singleton()) {
+		TRResourceCache::get_singleton()->set_cache_path(resource_cache_path);
+	}
+
+	load_thread.start(_load_level_thread, this);
+
+	return OK;
+}
+
+void TRLevel::cancel_level_load() {
+	if (load_thread.is_started()) {
+		load_progress.cancelled.set();
+	}
+}
+
+void TRLevel::_load_level_thread(void *p_userdata) {
+	TRLevel *level = static_cast<TRLevel *>(p_userdata);
+
+	level->load_progress.report(TR_LOAD_PHASE_PARSE, 0.0);
+	Ref<TRLevelData> level_data = level->load_level_type();
+
+	if (level_data.is_valid() && !level->load_progress.is_cancelled()) {
+		level->async_staging_root = memnew(Node3D);
+		Node3D *result = generate_godot_scene(
+			level->async_staging_root,
+			level_data,
+			level->async_lara_only,
+			level->use_resource_cache,
+			level->scene_options,
+			&level->load_progress,
+			&level->load_statistics);
+
+		level->async_load_succeeded = result != nullptr && !level->load_progress.is_cancelled();
+	}
+
+	callable_mp(level, &TRLevel::_finish_async_load).call_deferred();
+}
+
+void TRLevel::_emit_load_progress(const String &p_phase, real_t p_progress) {
+	emit_signal("load_progress", p_phase, p_progress);
+}
+
+void TRLevel::_finish_async_load() {
+	if (load_thread.is_started()) {
+		load_thread.wait_to_finish();
+	}
+
+	bool success = async_load_succeeded && !load_progress.is_cancelled();
+
+	if (async_staging_root) {
+		if (success) {
+			clear_level();
+
+			Node *scene_owner = get_owner() != nullptr ? get_owner() : this;
+			while (async_staging_root->get_child_count() > 0) {
+				Node *child = async_staging_root->get_child(0);
+				async_staging_root->remove_child(child);
+				add_child(child);
+				set_owner_recursively(child, scene_owner);
+			}
+		}
+
+		memdelete(async_staging_root);
+		async_staging_root = nullptr;
+	}
+
+	load_progress.progress_callback = Callable();
+
+	_finish_load_statistics();
+
+	if (success && warm_up_shaders && is_inside_tree()) {
+		start_shader_warmup();
+	}
+
+	emit_signal("load_finished", success);
+}
+
+struct TRShaderWarmupSurface {
+	Ref<Material> material;
+	uint64_t format = 0;
+};
+
+// Each material is drawn with the vertex format of the first surface using it.
+static void collect_level_materials(Node *p_node, LocalVector<TRShaderWarmupSurface> &r_surfaces, HashSet<RID> &r_material_rids) {
+	Ref<Mesh> mesh;
+	if (MeshInstance3D *mesh_instance = Object::cast_to<MeshInstance3D>(p_node)) {
+		mesh = mesh_instance->get_mesh();
+	} else if (MultiMeshInstance3D *multimesh_instance = Object::cast_to<MultiMeshInstance3D>(p_node)) {
+		if (multimesh_instance->get_multimesh().is_valid()) {
+			mesh = multimesh_instance->get_multimesh()->get_mesh();
+		}
+	}
+
+	if (mesh.is_valid()) {
+		for (int32_t i = 0; i < mesh->get_surface_count(); i++) {
+			Ref<Material> material = mesh->surface_get_material(i);
+			if (material.is_valid() && !r_material_rids.has(material->get_rid())) {
+				r_material_rids.insert(material->get_rid());
+
+				TRShaderWarmupSurface surface;
+				surface.material = material;
+				surface.format = mesh->surface_get_format(i);
+				r_surfaces.push_back(surface);
+			}
+		}
+	}
+
+	for (int32_t i = 0; i < p_node->get_child_count(); i++) {
+		collect_level_materials(p_node->get_child(i), r_surfaces, r_material_rids);
+	}
+}
+
+// Zeroed custom channel data for p_vertex_count vertices in the given custom format.
+static Variant create_shader_warmup_custom_array(Mesh::ArrayCustomFormat p_custom_format, int32_t p_vertex_count) {
+	switch (p_custom_format) {
+		case Mesh::ARRAY_CUSTOM_RGBA8_UNORM:
+		case Mesh::ARRAY_CUSTOM_RGBA8_SNORM:
+		case Mesh::ARRAY_CUSTOM_RG_HALF: {
+			PackedByteArray data;
+			data.resize(p_vertex_count * 4);
+			data.fill(0);
+			return data;
+		}
+		case Mesh::ARRAY_CUSTOM_RGBA_HALF: {
+			PackedByteArray data;
+			data.resize(p_vertex_count * 8);
+			data.fill(0);
+			return data;
+		}
+		default: {
+			int32_t component_count = p_custom_format - Mesh::ARRAY_CUSTOM_R_FLOAT + 1;
+			PackedFloat32Array data;
+			data.resize(p_vertex_count * component_count);
+			data.fill(0.0);
+			return data;
+		}
+	}
+}
+
+// A quad facing +Z carrying the same vertex attributes as p_format, so the
+// material gets the pipeline the level's own surfaces will ask for (vertex
+// colours for room lighting, CUSTOM0 layers for texture array rooms).
+static Ref<ArrayMesh> create_shader_warmup_quad(uint64_t p_format, real_t p_size) {
+	const int32_t vertex_count = 4;
+	real_t half_size = p_size * 0.5;
+
+	Array arrays;
+	arrays.resize(Mesh::ARRAY_MAX);
+
+	PackedVector3Array vertices;
+	vertices.push_back(Vector3(-half_size, -half_size, 0.0));
+	vertices.push_back(Vector3(half_size, -half_size, 0.0));
+	vertices.push_back(Vector3(half_size, half_size, 0.0));
+	vertices.push_back(Vector3(-half_size, half_size, 0.0));
+	arrays[Mesh::ARRAY_VERTEX] = vertices;
+
+	PackedVector3Array normals;
+	normals.resize(vertex_count);
+	normals.fill(Vector3(0.0, 0.0, 1.0));
+	arrays[Mesh::ARRAY_NORMAL] = normals;
+
+	if (p_format & Mesh::ARRAY_FORMAT_TANGENT) {
+		PackedFloat32Array tangents;
+		for (int32_t i = 0; i < vertex_count; i++) {
+			tangents.push_back(1.0);
+			tangents.push_back(0.0);
+			tangents.push_back(0.0);
+			tangents.push_back(1.0);
+		}
+		arrays[Mesh::ARRAY_TANGENT] = tangents;
+	}
+
+	if (p_format & Mesh::ARRAY_FORMAT_COLOR) {
+		PackedColorArray colors;
+		colors.resize(vertex_count);
+		colors.fill(Color(1.0, 1.0, 1.0, 1.0));
+		arrays[Mesh::ARRAY_COLOR] = colors;
+	}
+
+	PackedVector2Array uvs;
+	uvs.push_back(Vector2(0.0, 1.0));
+	uvs.push_back(Vector2(1.0, 1.0));
+	uvs.push_back(Vector2(1.0, 0.0));
+	uvs.push_back(Vector2(0.0, 0.0));
+	if (p_format & Mesh::ARRAY_FORMAT_TEX_UV) {
+		arrays[Mesh::ARRAY_TEX_UV] = uvs;
+	}
+	if (p_format & Mesh::ARRAY_FORMAT_TEX_UV2) {
+		arrays[Mesh::ARRAY_TEX_UV2] = uvs;
+	}
+
+	uint64_t flags = p_format & Mesh::ARRAY_FLAG_COMPRESS_ATTRIBUTES;
+	for (int32_t custom = 0; custom < Mesh::ARRAY_CUSTOM_COUNT; custom++) {
+		if (!(p_format & (uint64_t(Mesh::ARRAY_FORMAT_CUSTOM0) << custom))) {
+			continue;
+		}
+		int32_t shift = Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT + custom * Mesh::ARRAY_FORMAT_CUSTOM_BITS;
+		Mesh::ArrayCustomFormat custom_format = Mesh::ArrayCustomFormat((p_format >> shift) & Mesh::ARRAY_FORMAT_CUSTOM_MASK);
+		arrays[Mesh::ARRAY_CUSTOM0 + custom] = create_shader_warmup_custom_array(custom_format, vertex_count);
+		flags |= uint64_t(custom_format) << shift;
+	}
+
+	// Clockwise as seen from the camera in front of it.
+	PackedInt32Array indices = { 0, 3, 2, 0, 2, 1 };
+	arrays[Mesh::ARRAY_INDEX] = indices;
+
+	Ref<ArrayMesh> quad_mesh;
+	quad_mesh.instantiate();
+	quad_mesh->add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, arrays, Array(), Dictionary(), flags);
+	return quad_mesh;
+}
+
+// Draws one small quad per material of the level into a hidden viewport with its own
+// world, so every shader variant, stencil-read versions included, has its pipelines
+// compiled before the level is shown. The level stays hidden until then.
+void TRLevel::start_shader_warmup() {
+	ERR_FAIL_COND_MSG(!is_inside_tree(), "The level must be inside the scene tree to warm up its shaders.");
+	ERR_FAIL_COND_MSG(shader_warmup_viewport != nullptr, "Shader warm-up is already running.");
+
+	LocalVector<TRShaderWarmupSurface> surfaces;
+	HashSet<RID> material_rids;
+	collect_level_materials(this, surfaces, material_rids);
+
+	shader_warmup_viewport = memnew(SubViewport);
+	shader_warmup_viewport->set_name("ShaderWarmup");
+	shader_warmup_viewport->set_size(Size2i(64, 64));
+	shader_warmup_viewport->set_use_own_world_3d(true);
+	shader_warmup_viewport->set_update_mode(SubViewport::UPDATE_ALWAYS);
+
+	Camera3D *camera = memnew(Camera3D);
+	shader_warmup_viewport->add_child(camera);
+	camera->make_current();
+
+	// Lay the quads out on a grid in front of the camera so none of them is culled.
+	int32_t grid_size = MAX(int32_t(Math::ceil(Math::sqrt(real_t(surfaces.size())))), 1);
+	real_t cell_size = 1.0 / grid_size;
+	HashMap<uint64_t, Ref<ArrayMesh>> quad_meshes;
+
+	for (uint32_t i = 0; i < surfaces.size(); i++) {
+		if (!quad_meshes.has(surfaces[i].format)) {
+			quad_meshes.insert(surfaces[i].format, create_shader_warmup_quad(surfaces[i].format, cell_size));
+		}
+
+		MeshInstance3D *mesh_instance = memnew(MeshInstance3D);
+		mesh_instance->set_mesh(quad_meshes[surfaces[i].format]);
+		mesh_instance->set_material_override(surfaces[i].material);
+		mesh_instance->set_position(Vector3(
+			((i % grid_size) + 0.5) * cell_size - 0.5,
+			((i / grid_size) + 0.5) * cell_size - 0.5,
+			-1.0));
+		shader_warmup_viewport->add_child(mesh_instance);
+	}
+
+	visible_before_shader_warmup = is_visible();
+	set_visible(false);
+
+	add_child(shader_warmup_viewport, false, INTERNAL_MODE_BACK);
+
+	// Pipelines are compiled while the first frames are drawn.
+	shader_warmup_frames_left = 2;
+	RenderingServer::get_singleton()->connect("frame_post_draw", callable_mp(this, &TRLevel::_shader_warmup_frame));
+	shader_warmup_connected = true;
+}
+
+void TRLevel::_shader_warmup_frame() {
+	shader_warmup_frames_left--;
+	if (shader_warmup_frames_left <= 0) {
+		RenderingServer::get_singleton()->disconnect("frame_post_draw", callable_mp(this, &TRLevel::_shader_warmup_frame));
+		shader_warmup_connected = false;
+		callable_mp(this, &TRLevel::_finish_shader_warmup).call_deferred();
 	}
 }
 
+void TRLevel::_finish_shader_warmup() {
+	ERR_FAIL_NULL(shader_warmup_viewport);
+
+	int32_t material_count = shader_warmup_viewport->get_child_count() - 1;
+
+	remove_child(shader_warmup_viewport);
+	memdelete(shader_warmup_viewport);
+	shader_warmup_viewport = nullptr;
+
+	set_visible(visible_before_shader_warmup);
+
+	emit_signal("shader_warmup_finished", material_count);
+}
+
 Ref<TRLevelData> TRLevel::load_level_data(
 	Ref<TRFileAccess> level_file,
 	Ref<TRLevelData> level_data,
 	TRLevelFormat format,
 	Ref<TRFileAccess> auxiliary_animation_file) {
+	TR_SCOPED_TIMER(&load_statistics, "load_level_data");
 
 	Vector<TRColor3> palette;
 
@@ -1445,18 +1836,35 @@ Ref<TRLevelData> TRLevel::load_level_data(
 			level_data->texture_type = TR_TEXTURE_TYPE_16;
 		}
 
+		TR_SCOPED_TIMER(&load_statistics, "texture_page_parse");
 		Vector<PackedByteArray> textures = read_tr_texture_pages(level_file, format);
 		level_data->level_textures = textures;
 		level_data->entity_textures = textures;
 	}
 
+	if (load_progress.is_cancelled()) {
+		return Ref<TRLevelData>();
+	}
+
 	int32_t file_level_num = level_file->get_s32();
 
+	TRScopedTimer room_parse_timer(&load_statistics, "room_parse");
 	Vector<TRRoom> rooms = read_tr_rooms(level_file, format);
+	room_parse_timer.stop();
+	load_progress.report(TR_LOAD_PHASE_PARSE, level_file->get_position(), level_file->get_size());
+	if (load_progress.is_cancelled()) {
+		return Ref<TRLevelData>();
+	}
 
 	PackedByteArray floor_data = read_tr_floor_data(level_file);
 
+	TRScopedTimer animation_decode_timer(&load_statistics, "animation_decode");
 	TRTypes types = read_tr_types(level_file, auxiliary_animation_file, format);
+	animation_decode_timer.stop();
+	load_progress.report(TR_LOAD_PHASE_PARSE, level_file->get_position(), level_file->get_size());
+	if (load_progress.is_cancelled()) {
+		return Ref<TRLevelData>();
+	}
 
 	if (format == TR1_PC || format == TR2_PC) {
 		types.texture_infos = read_tr_texture_infos(level_file, format);
@@ -1472,7 +1880,7 @@ Ref<TRLevelData> TRLevel::load_level_data(
 
 	read_tr_flyby_cameras(level_file, format);
 
-	read_tr_sound_effects(level_file);
+	Vector<TRObjectVector> sound_sources = read_tr_sound_effects(level_file);
 
 	read_tr_nav_cells(level_file, format);
 
@@ -1486,6 +1894,10 @@ Ref<TRLevelData> TRLevel::load_level_data(
 	}
 
 	Vector<TREntity> entities = read_tr_entities(level_file, format);
+	load_progress.report(TR_LOAD_PHASE_PARSE, level_file->get_position(), level_file->get_size());
+	if (load_progress.is_cancelled()) {
+		return Ref<TRLevelData>();
+	}
 
 	if (format == TR4_PC) {
 		read_tr_ai_objects(level_file, format);
@@ -1528,6 +1940,8 @@ Ref<TRLevelData> TRLevel::load_level_data(
 		sound_indices = read_tr_sound_indices(level_file);
 	}
 
+	TR_SCOPED_TIMER(&load_statistics, "sfx_parse");
+
 	Error sfx_error;
 	String directory_path = level_path.get_base_dir();
 	Ref<TRFileAccess> sfx_file;
@@ -1622,6 +2036,7 @@ Ref<TRLevelData> TRLevel::load_level_data(
 	level_data->is_using_auxiliary_animation = auxiliary_animation_file.is_valid();
 	level_data->rooms = rooms;
 	level_data->entities = entities;
+	level_data->sound_sources = sound_sources;
 	level_data->types = types;
 	level_data->floor_data = floor_data;
 	level_data->sound_map = sound_map;
@@ -1633,6 +2048,8 @@ Ref<TRLevelData> TRLevel::load_level_data(
 }
 
 Ref<TRLevelData> TRLevel::load_level_type() {
+	TR_SCOPED_TIMER(&load_statistics, "load_level_type");
+
 	Error error;
 	Ref<TRLevelData> level_data;
 	level_data.instantiate();
@@ -1641,6 +2058,7 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 
 	level_data->format = TR1_PC;
 
+	TRScopedTimer file_read_timer(&load_statistics, "file_read");
 	Ref<TRFileAccess> level_file = TRFileAccess::open(level_path, &error);
 	if (error != Error::OK) {
 		return level_data;
@@ -1651,6 +2069,7 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 	if (error != Error::OK) {
 		auxiliary_animation_file = nullptr;
 	}
+	file_read_timer.stop();
 
 	TRLevelFormat format = TR1_PC;
 	int32_t version = level_file->get_s32();
@@ -1684,7 +2103,10 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 		textiles32_decompressed_buffer.resize(textiles32_decompressed_size);
 
 		Compression compression_32;
-		compression_32.decompress(textiles32_decompressed_buffer.ptrw(), textiles32_decompressed_size, textiles32_compressed_buffer.ptr(), textiles32_compressed_size, Compression::MODE_DEFLATE);
+		{
+			TR_SCOPED_TIMER(&load_statistics, "decompression");
+			compression_32.decompress(textiles32_decompressed_buffer.ptrw(), textiles32_decompressed_size, textiles32_compressed_buffer.ptr(), textiles32_compressed_size, Compression::MODE_DEFLATE);
+		}
 
 		// 16-Bit
 		uint32_t textiles16_decompressed_size = level_file->get_u32();
@@ -1695,7 +2117,10 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 		textiles16_decompressed_buffer.resize(textiles16_decompressed_size);
 
 		Compression compression_16;
-		compression_16.decompress(textiles16_decompressed_buffer.ptrw(), textiles16_decompressed_size, textiles16_compressed_buffer.ptr(), textiles16_compressed_size, Compression::MODE_DEFLATE);
+		{
+			TR_SCOPED_TIMER(&load_statistics, "decompression");
+			compression_16.decompress(textiles16_decompressed_buffer.ptrw(), textiles16_decompressed_size, textiles16_compressed_buffer.ptr(), textiles16_compressed_size, Compression::MODE_DEFLATE);
+		}
 
 
 		Ref<TRFileAccess> uncompressed_file_access = TRFileAccess::create_from_buffer(textiles32_decompressed_buffer);
@@ -1713,7 +2138,10 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 		font_and_sky_decompressed_buffer.resize(font_and_sky_decompressed_size);
 
 		Compression font_and_sky_compression;
-		font_and_sky_compression.decompress(font_and_sky_decompressed_buffer.ptrw(), font_and_sky_decompressed_size, font_and_sky_compressed_buffer.ptr(), font_and_sky_compressed_size, Compression::MODE_DEFLATE);
+		{
+			TR_SCOPED_TIMER(&load_statistics, "decompression");
+			font_and_sky_compression.decompress(font_and_sky_decompressed_buffer.ptrw(), font_and_sky_decompressed_size, font_and_sky_compressed_buffer.ptr(), font_and_sky_compressed_size, Compression::MODE_DEFLATE);
+		}
 
 		level_data->level_textures = level_textures;
 		level_data->entity_textures = entity_textures;
@@ -1729,7 +2157,10 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 			other_decompressed_buffer.resize(other_decompressed_size);
 
 			Compression other_compression;
-			other_compression.decompress(other_decompressed_buffer.ptrw(), other_decompressed_size, other_compressed_buffer.ptr(), other_compressed_size, Compression::MODE_DEFLATE);
+			{
+				TR_SCOPED_TIMER(&load_statistics, "decompression");
+				other_compression.decompress(other_decompressed_buffer.ptrw(), other_decompressed_size, other_compressed_buffer.ptr(), other_compressed_size, Compression::MODE_DEFLATE);
+			}
 
 			level_data = load_level_data(TRFileAccess::create_from_buffer(other_decompressed_buffer), level_data, format, auxiliary_animation_file);
 		} else {
@@ -1748,6 +2179,11 @@ Ref<TRLevelData> TRLevel::load_level_type() {
 		level_data = load_level_data(level_file, level_data, format, auxiliary_animation_file);
 	}
 
+	// Cancelled mid-parse.
+	if (level_data.is_null()) {
+		return level_data;
+	}
+
 	level_data->format = format;
 	level_data->is_using_auxiliary_animation = auxiliary_animation_file.is_valid();
 
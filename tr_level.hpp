@@ -3,11 +3,14 @@
 #include "tr_module_extension_abstraction_layer.hpp"
 
 #include "tr_file_parser.hpp"
+#include "tr_load_statistics.hpp"
 
 #ifdef IS_MODULE
 #include "scene/3d/node_3d.h"
 #include "core/object/class_db.h"
 #include "core/string/ustring.h"
+#include "core/os/thread.h"
+#include "core/templates/safe_refcount.h"
 #else 
 using namespace godot;
 #include <godot_cpp/classes/node3D.hpp>
@@ -30,10 +33,161 @@ enum TRLevelFormat {
 
 const real_t TR_FPS = 30.0f;
 
+enum TRLoadPhase {
+	TR_LOAD_PHASE_PARSE,
+	TR_LOAD_PHASE_TEXTURES,
+	TR_LOAD_PHASE_MESHES,
+	TR_LOAD_PHASE_ANIMATIONS,
+	TR_LOAD_PHASE_ROOMS,
+	TR_LOAD_PHASE_MAX,
+};
+
+inline String get_load_phase_name(TRLoadPhase p_phase) {
+	switch (p_phase) {
+		case TR_LOAD_PHASE_PARSE:
+			return "parse";
+		case TR_LOAD_PHASE_TEXTURES:
+			return "textures";
+		case TR_LOAD_PHASE_MESHES:
+			return "meshes";
+		case TR_LOAD_PHASE_ANIMATIONS:
+			return "animations";
+		case TR_LOAD_PHASE_ROOMS:
+			return "rooms";
+		default:
+			return "";
+	}
+}
+
+// Shared between a loading thread and the main thread. Progress is forwarded
+// to the callback as a deferred call so listeners always run on the main thread.
+struct TRLoadProgress {
+	Callable progress_callback;
+	SafeFlag cancelled;
+	int32_t last_reported_percent = -1;
+
+	void reset(const Callable &p_progress_callback) {
+		progress_callback = p_progress_callback;
+		cancelled.clear();
+		last_reported_percent = -1;
+	}
+
+	void report(TRLoadPhase p_phase, real_t p_phase_progress) {
+		if (!progress_callback.is_valid()) {
+			return;
+		}
+
+		real_t overall_progress = (real_t(p_phase) + CLAMP(p_phase_progress, 0.0, 1.0)) / real_t(TR_LOAD_PHASE_MAX);
+		int32_t percent = int32_t(overall_progress * 100.0);
+		if (percent == last_reported_percent) {
+			return;
+		}
+		last_reported_percent = percent;
+
+		progress_callback.call_deferred(get_load_phase_name(p_phase), overall_progress);
+	}
+
+	void report(TRLoadPhase p_phase, int64_t p_index, int64_t p_count) {
+		report(p_phase, p_count > 0 ? real_t(p_index) / real_t(p_count) : 1.0);
+	}
+
+	bool is_cancelled() const { return cancelled.is_set(); }
+};
+
+enum TRTextureCompression {
+	TR_TEXTURE_COMPRESSION_NONE,
+	TR_TEXTURE_COMPRESSION_S3TC, // BC1, or BC3 for pages with cutouts.
+	TR_TEXTURE_COMPRESSION_BPTC, // BC7
+	TR_TEXTURE_COMPRESSION_ETC2,
+	TR_TEXTURE_COMPRESSION_MAX,
+};
+
+enum TRRoomLightingMode {
+	TR_ROOM_LIGHTING_DYNAMIC, // OmniLight3D per room light and a ReflectionProbe per room.
+	TR_ROOM_LIGHTING_LIGHT_LIST,
+	TR_ROOM_LIGHTING_MAX,
+};
+
+enum TRRoomCollision {
+	TR_ROOM_COLLISION_TRIMESH, // One ConcavePolygonShape3D per room.
+	TR_ROOM_COLLISION_SECTOR_GRID,
+	TR_ROOM_COLLISION_MAX,
+};
+
+enum TRStaticMeshBatching {
+	TR_STATIC_MESH_BATCHING_NONE, // One MeshInstance3D per static mesh.
+	TR_STATIC_MESH_BATCHING_PER_ROOM,
+	TR_STATIC_MESH_BATCHING_GLOBAL,
+	TR_STATIC_MESH_BATCHING_MERGED, // Baked into the room mesh where possible.
+	TR_STATIC_MESH_BATCHING_MAX,
+};
+
+// Optional conversion paths for generate_godot_scene. The defaults reproduce
+// the original output of one material and one surface per texture page.
+struct TRSceneOptions {
+	// All pages go into one Texture2DArray and rooms are built from at most
+	// two surfaces (opaque, alpha scissor) with the page index in CUSTOM0.
+	bool use_texture_array = false;
+	// Every texture region the level uses is repacked into as few atlas pages
+	// as possible, which cuts the number of materials and surfaces per room.
+	bool use_texture_atlas = false;
+	// Pages get a mip chain built per chart and are sampled with nearest mipmap filtering.
+	bool generate_mipmaps = false;
+	// Compresses texture pages (or atlas pages) at import time. Needs the
+	// compressors of an editor build; pages are left as RGBA8 otherwise.
+	TRTextureCompression texture_compression = TR_TEXTURE_COMPRESSION_NONE;
+	// TR1 pages stay 8-bit palette indices on the GPU (R8 plus a 256x1 palette)
+	// and are resolved in the shaders. Excludes mipmaps and compression.
+	bool use_palette_textures = false;
+	// Room static meshes sharing a mesh are drawn as one MultiMeshInstance3D,
+	// either per room (so they are culled with it) or across the whole level.
+	// Merging bakes them into the room's own surfaces instead.
+	TRStaticMeshBatching static_mesh_batching = TR_STATIC_MESH_BATCHING_NONE;
+	// Light list mode skips the OmniLight3D and ReflectionProbe nodes; entities
+	// are lit in their shaders from the nearest lights of their room instead.
+	TRRoomLightingMode room_lighting = TR_ROOM_LIGHTING_DYNAMIC;
+	// Sector grid collision uses heightmaps for flat-cornered floors and
+	// ceilings and boxes for solid sectors, keeping a trimesh only for the
+	// faces neither can represent.
+	TRRoomCollision room_collision = TR_ROOM_COLLISION_TRIMESH;
+	// Rooms whose interiors overlap without a portal between them are moved
+	// to their own stencil layers. Such rooms are only built as the dummy
+	// rooms seen through layer 0's portals, so this is opt-in.
+	bool use_room_stencil_layers = false;
+};
+
+class SubViewport;
+
 class TRLevel : public Node3D {
 	GDCLASS(TRLevel, Node3D);
 protected:
 	String level_path;
+	bool use_resource_cache = false;
+	String resource_cache_path = "res://gdraider/shared/";
+
+	TRSceneOptions scene_options;
+
+	String load_trace_path;
+	TRLoadStatistics load_statistics;
+
+	Thread load_thread;
+	TRLoadProgress load_progress;
+	bool async_lara_only = false;
+	bool async_load_succeeded = false;
+	Node3D *async_staging_root = nullptr;
+
+	bool warm_up_shaders = false;
+	SubViewport *shader_warmup_viewport = nullptr;
+	int32_t shader_warmup_frames_left = 0;
+	bool shader_warmup_connected = false;
+	bool visible_before_shader_warmup = true;
+
+	static void _load_level_thread(void *p_userdata);
+	void _emit_load_progress(const String &p_phase, real_t p_progress);
+	void _finish_async_load();
+	void _finish_load_statistics();
+	void _shader_warmup_frame();
+	void _finish_shader_warmup();
 
 	static void _bind_methods();
 public:
@@ -45,8 +199,50 @@ public:
 	String get_level_path() { return level_path; }
 	void set_level_path(String p_level_path) { level_path = p_level_path; }
 
+	bool get_use_resource_cache() { return use_resource_cache; }
+	void set_use_resource_cache(bool p_use_resource_cache) { use_resource_cache = p_use_resource_cache; }
+
+	String get_resource_cache_path() { return resource_cache_path; }
+	void set_resource_cache_path(String p_resource_cache_path) { resource_cache_path = p_resource_cache_path; }
+
+	bool get_use_texture_array() { return scene_options.use_texture_array; }
+	void set_use_texture_array(bool p_use_texture_array) { scene_options.use_texture_array = p_use_texture_array; }
+	bool get_use_texture_atlas() { return scene_options.use_texture_atlas; }
+	void set_use_texture_atlas(bool p_use_texture_atlas) { scene_options.use_texture_atlas = p_use_texture_atlas; }
+	bool get_generate_mipmaps() { return scene_options.generate_mipmaps; }
+	void set_generate_mipmaps(bool p_generate_mipmaps) { scene_options.generate_mipmaps = p_generate_mipmaps; }
+	bool get_use_palette_textures() { return scene_options.use_palette_textures; }
+	void set_use_palette_textures(bool p_use_palette_textures) { scene_options.use_palette_textures = p_use_palette_textures; }
+	int32_t get_texture_compression() { return scene_options.texture_compression; }
+	void set_texture_compression(int32_t p_texture_compression) { scene_options.texture_compression = TRTextureCompression(CLAMP(p_texture_compression, 0, TR_TEXTURE_COMPRESSION_MAX - 1)); }
+
+	int32_t get_static_mesh_batching() { return scene_options.static_mesh_batching; }
+	void set_static_mesh_batching(int32_t p_static_mesh_batching) { scene_options.static_mesh_batching = TRStaticMeshBatching(CLAMP(p_static_mesh_batching, 0, TR_STATIC_MESH_BATCHING_MAX - 1)); }
+
+	int32_t get_room_lighting() { return scene_options.room_lighting; }
+	void set_room_lighting(int32_t p_room_lighting) { scene_options.room_lighting = TRRoomLightingMode(CLAMP(p_room_lighting, 0, TR_ROOM_LIGHTING_MAX - 1)); }
+
+	int32_t get_room_collision() { return scene_options.room_collision; }
+	void set_room_collision(int32_t p_room_collision) { scene_options.room_collision = TRRoomCollision(CLAMP(p_room_collision, 0, TR_ROOM_COLLISION_MAX - 1)); }
+
+	bool get_use_room_stencil_layers() { return scene_options.use_room_stencil_layers; }
+	void set_use_room_stencil_layers(bool p_use_room_stencil_layers) { scene_options.use_room_stencil_layers = p_use_room_stencil_layers; }
+
+	bool get_warm_up_shaders() { return warm_up_shaders; }
+	void set_warm_up_shaders(bool p_warm_up_shaders) { warm_up_shaders = p_warm_up_shaders; }
+
+	String get_load_trace_path() { return load_trace_path; }
+	void set_load_trace_path(String p_load_trace_path) { load_trace_path = p_load_trace_path; }
+
+	Dictionary get_load_statistics() { return load_statistics.get_statistics(); }
+
 	void clear_level();
 	void load_level(bool p_lara_only);
+	Error load_level_async(bool p_lara_only);
+	void cancel_level_load();
+	bool is_loading() const { return load_thread.is_started(); }
+	void start_shader_warmup();
+	bool is_warming_up_shaders() const { return shader_warmup_viewport != nullptr; }
 	Ref<TRLevelData> load_level_data(Ref<TRFileAccess> level_file,
 		Ref<TRLevelData> level_data,
 		TRLevelFormat format,
@@ -0,0 +1,186 @@
+#include "tr_level_collision.hpp"
+
+// Bound on portals followed by a single query, so malformed levels with portal
+// loops can't stall it.
+const int32_t TR_LEVEL_COLLISION_MAX_PORTAL_HOPS = 16;
+
+enum {
+	TR_COLLISION_CORNER_NW,
+	TR_COLLISION_CORNER_NE,
+	TR_COLLISION_CORNER_SW,
+	TR_COLLISION_CORNER_SE,
+};
+
+void TRLevelCollision::_bind_methods() {
+	ClassDB::bind_method("set_rooms", &TRLevelCollision::set_rooms);
+	ClassDB::bind_method("get_rooms", &TRLevelCollision::get_rooms);
+
+	ClassDB::bind_method("get_sector_room", &TRLevelCollision::get_sector_room);
+	ClassDB::bind_method("get_floor_height", &TRLevelCollision::get_floor_height);
+	ClassDB::bind_method("get_ceiling_height", &TRLevelCollision::get_ceiling_height);
+	ClassDB::bind_method("is_wall", &TRLevelCollision::is_wall);
+	ClassDB::bind_method("get_room_below", &TRLevelCollision::get_room_below);
+	ClassDB::bind_method("get_room_above", &TRLevelCollision::get_room_above);
+
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "rooms", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_rooms", "get_rooms");
+}
+
+static int32_t get_tr_collision_room_index(int32_t p_room, int32_t p_room_count) {
+	return p_room >= 0 && p_room < p_room_count ? p_room : -1;
+}
+
+void TRLevelCollision::set_rooms(const Array &p_rooms) {
+	room_data = p_rooms;
+	rooms.clear();
+	rooms.resize(p_rooms.size());
+
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		Dictionary data = p_rooms[room_idx];
+		Room &room = rooms[room_idx];
+
+		room.sector_origin = data.get("sector_origin", Vector2());
+		room.sector_size = data.get("sector_size", 0.0);
+		room.sector_columns = data.get("sector_columns", 0);
+		room.sector_rows = data.get("sector_rows", 0);
+
+		PackedFloat32Array floor_corners = data.get("sector_floor_corners", PackedFloat32Array());
+		PackedFloat32Array ceiling_corners = data.get("sector_ceiling_corners", PackedFloat32Array());
+		PackedByteArray flags = data.get("sector_flags", PackedByteArray());
+		PackedInt32Array rooms_below = data.get("sector_rooms_below", PackedInt32Array());
+		PackedInt32Array rooms_above = data.get("sector_rooms_above", PackedInt32Array());
+		PackedInt32Array portal_rooms = data.get("sector_portal_rooms", PackedInt32Array());
+
+		int32_t sector_count = room.sector_columns * room.sector_rows;
+		if (floor_corners.size() != sector_count * 4 || ceiling_corners.size() != sector_count * 4 || flags.size() != sector_count ||
+				rooms_below.size() != sector_count || rooms_above.size() != sector_count || portal_rooms.size() != sector_count) {
+			ERR_PRINT("Room " + itos(room_idx) + " has a malformed collision grid.");
+			room.sector_columns = 0;
+			room.sector_rows = 0;
+			continue;
+		}
+
+		room.sectors.resize(sector_count);
+		for (int32_t sector_idx = 0; sector_idx < sector_count; sector_idx++) {
+			Sector &sector = room.sectors[sector_idx];
+			for (int32_t corner = 0; corner < 4; corner++) {
+				sector.floor[corner] = floor_corners[sector_idx * 4 + corner];
+				sector.ceiling[corner] = ceiling_corners[sector_idx * 4 + corner];
+			}
+			sector.flags = flags[sector_idx];
+			sector.room_below = get_tr_collision_room_index(rooms_below[sector_idx], p_rooms.size());
+			sector.room_above = get_tr_collision_room_index(rooms_above[sector_idx], p_rooms.size());
+			sector.portal_room = get_tr_collision_room_index(portal_rooms[sector_idx], p_rooms.size());
+		}
+	}
+}
+
+const TRLevelCollision::Sector *TRLevelCollision::_get_sector(int32_t p_room, const Vector3 &p_position, int32_t &r_room) const {
+	// Door sectors hand the query over to the room on their other side.
+	for (int32_t hop = 0; hop < TR_LEVEL_COLLISION_MAX_PORTAL_HOPS; hop++) {
+		if (p_room < 0 || p_room >= int32_t(rooms.size())) {
+			return nullptr;
+		}
+
+		const Room &room = rooms[p_room];
+		if (room.sector_size <= 0.0) {
+			return nullptr;
+		}
+
+		int32_t column = int32_t(Math::floor((p_position.x - room.sector_origin.x) / room.sector_size));
+		int32_t row = int32_t(Math::floor((-p_position.z - room.sector_origin.y) / room.sector_size));
+		if (column < 0 || column >= room.sector_columns || row < 0 || row >= room.sector_rows) {
+			return nullptr;
+		}
+
+		const Sector &sector = room.sectors[column * room.sector_rows + row];
+		if (sector.portal_room < 0) {
+			r_room = p_room;
+			return &sector;
+		}
+		p_room = sector.portal_room;
+	}
+
+	return nullptr;
+}
+
+const TRLevelCollision::Sector *TRLevelCollision::_get_vertical_sector(int32_t p_room, const Vector3 &p_position, bool p_ceiling, real_t &r_height) const {
+	for (int32_t hop = 0; hop < TR_LEVEL_COLLISION_MAX_PORTAL_HOPS; hop++) {
+		int32_t sector_room = -1;
+		const Sector *sector = _get_sector(p_room, p_position, sector_room);
+		if (!sector || (sector->flags & TR_COLLISION_SECTOR_WALL)) {
+			return nullptr;
+		}
+
+		const Room &room = rooms[sector_room];
+		real_t u = (p_position.x - room.sector_origin.x) / room.sector_size;
+		real_t v = (-p_position.z - room.sector_origin.y) / room.sector_size;
+		u -= Math::floor(u);
+		v -= Math::floor(v);
+
+		const real_t *corners = p_ceiling ? sector->ceiling : sector->floor;
+		bool split_nw_se = sector->flags & (p_ceiling ? TR_COLLISION_SECTOR_CEILING_SPLIT_NW_SE : TR_COLLISION_SECTOR_FLOOR_SPLIT_NW_SE);
+		uint8_t first_portal = p_ceiling ? TR_COLLISION_SECTOR_CEILING_FIRST_PORTAL : TR_COLLISION_SECTOR_FLOOR_FIRST_PORTAL;
+		uint8_t second_portal = p_ceiling ? TR_COLLISION_SECTOR_CEILING_SECOND_PORTAL : TR_COLLISION_SECTOR_FLOOR_SECOND_PORTAL;
+		int32_t next_room = p_ceiling ? sector->room_above : sector->room_below;
+
+		// The first triangle holds the NW corner of an SW-NE split and the SW
+		// corner of an NW-SE split.
+		bool first_triangle = split_nw_se ? v >= u : u + v <= 1.0;
+		bool portal = (sector->flags & (first_portal | second_portal)) ? bool(sector->flags & (first_triangle ? first_portal : second_portal)) : next_room >= 0;
+
+		if (portal) {
+			if (next_room < 0) {
+				return nullptr;
+			}
+			p_room = next_room;
+			continue;
+		}
+
+		const real_t nw = corners[TR_COLLISION_CORNER_NW];
+		const real_t ne = corners[TR_COLLISION_CORNER_NE];
+		const real_t sw = corners[TR_COLLISION_CORNER_SW];
+		const real_t se = corners[TR_COLLISION_CORNER_SE];
+		if (split_nw_se) {
+			r_height = first_triangle ? nw + v * (sw - nw) + u * (se - sw) : nw + u * (ne - nw) + v * (se - ne);
+		} else {
+			r_height = first_triangle ? nw + u * (ne - nw) + v * (sw - nw) : se + (1.0 - u) * (sw - se) + (1.0 - v) * (ne - se);
+		}
+		return sector;
+	}
+
+	return nullptr;
+}
+
+int32_t TRLevelCollision::get_sector_room(int32_t p_room, const Vector3 &p_position) const {
+	int32_t sector_room = -1;
+	_get_sector(p_room, p_position, sector_room);
+	return sector_room;
+}
+
+real_t TRLevelCollision::get_floor_height(int32_t p_room, const Vector3 &p_position) const {
+	real_t height = 0.0;
+	return _get_vertical_sector(p_room, p_position, false, height) ? height : Math::NaN;
+}
+
+real_t TRLevelCollision::get_ceiling_height(int32_t p_room, const Vector3 &p_position) const {
+	real_t height = 0.0;
+	return _get_vertical_sector(p_room, p_position, true, height) ? height : Math::NaN;
+}
+
+bool TRLevelCollision::is_wall(int32_t p_room, const Vector3 &p_position) const {
+	int32_t sector_room = -1;
+	const Sector *sector = _get_sector(p_room, p_position, sector_room);
+	return !sector || (sector->flags & TR_COLLISION_SECTOR_WALL);
+}
+
+int32_t TRLevelCollision::get_room_below(int32_t p_room, const Vector3 &p_position) const {
+	int32_t sector_room = -1;
+	const Sector *sector = _get_sector(p_room, p_position, sector_room);
+	return sector ? sector->room_below : -1;
+}
+
+int32_t TRLevelCollision::get_room_above(int32_t p_room, const Vector3 &p_position) const {
+	int32_t sector_room = -1;
+	const Sector *sector = _get_sector(p_room, p_position, sector_room);
+	return sector ? sector->room_above : -1;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "tr_module_extension_abstraction_layer.hpp"
+
+#ifdef IS_MODULE
+#include "scene/3d/node_3d.h"
+#include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
+#else
+using namespace godot;
+#include <godot_cpp/classes/node3D.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#endif
+
+// Per-sector flags of the collision grid. Split sectors are divided along the
+// NW-SE diagonal when flagged, along the SW-NE one otherwise. A portal
+// triangle is the half of a split floor (or ceiling) which opens into the room
+// below (or above) instead of being solid.
+enum TRLevelCollisionSectorFlags {
+	TR_COLLISION_SECTOR_WALL = 1 << 0,
+	TR_COLLISION_SECTOR_FLOOR_SPLIT_NW_SE = 1 << 1,
+	TR_COLLISION_SECTOR_FLOOR_FIRST_PORTAL = 1 << 2,
+	TR_COLLISION_SECTOR_FLOOR_SECOND_PORTAL = 1 << 3,
+	TR_COLLISION_SECTOR_CEILING_SPLIT_NW_SE = 1 << 4,
+	TR_COLLISION_SECTOR_CEILING_FIRST_PORTAL = 1 << 5,
+	TR_COLLISION_SECTOR_CEILING_SECOND_PORTAL = 1 << 6,
+};
+
+// Answers the collision queries of the original engines straight from the
+// rooms' sector grids and decoded floor data: floor and ceiling heights
+// (including sloped and triangulated sectors), walls, and the rooms linked
+// through each sector. Positions and returned heights are level-local, in this
+// node's space; world positions have to go through the inverse of
+// get_global_transform() first. The room passed in is a starting point, and
+// door and floor portals are followed from there.
+class TRLevelCollision : public Node3D {
+	GDCLASS(TRLevelCollision, Node3D);
+
+	struct Sector {
+		// Corner heights, ordered NW, NE, SW, SE.
+		real_t floor[4] = {};
+		real_t ceiling[4] = {};
+		uint8_t flags = 0;
+		int32_t room_below = -1;
+		int32_t room_above = -1;
+		int32_t portal_room = -1;
+	};
+
+	struct Room {
+		// Sector grid in Godot units. Columns run along X and rows along -Z.
+		Vector2 sector_origin;
+		real_t sector_size = 0.0;
+		int32_t sector_columns = 0;
+		int32_t sector_rows = 0;
+		LocalVector<Sector> sectors;
+	};
+
+	Array room_data;
+	LocalVector<Room> rooms;
+
+	const Sector *_get_sector(int32_t p_room, const Vector3 &p_position, int32_t &r_room) const;
+	const Sector *_get_vertical_sector(int32_t p_room, const Vector3 &p_position, bool p_ceiling, real_t &r_height) const;
+protected:
+	static void _bind_methods();
+public:
+	void set_rooms(const Array &p_rooms);
+	Array get_rooms() const { return room_data; }
+
+	int32_t get_sector_room(int32_t p_room, const Vector3 &p_position) const;
+	real_t get_floor_height(int32_t p_room, const Vector3 &p_position) const;
+	real_t get_ceiling_height(int32_t p_room, const Vector3 &p_position) const;
+	bool is_wall(int32_t p_room, const Vector3 &p_position) const;
+	int32_t get_room_below(int32_t p_room, const Vector3 &p_position) const;
+	int32_t get_room_above(int32_t p_room, const Vector3 &p_position) const;
+};
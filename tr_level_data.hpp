@@ -29,6 +29,7 @@ public:
 	PackedByteArray floor_data;
 	TRTypes types;
 	Vector<TREntity> entities;
+	Vector<TRObjectVector> sound_sources;
 	Vector<uint16_t> sound_map;
 	Vector<TRSoundInfo> sound_infos;
 	PackedByteArray sound_buffer;
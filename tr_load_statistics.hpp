@@ -0,0 +1,159 @@
+#pragma once
+
+#include "tr_module_extension_abstraction_layer.hpp"
+
+#include "core/io/file_access.h"
+#include "core/io/json.h"
+#include "core/os/memory.h"
+#include "core/os/mutex.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/variant/dictionary.h"
+
+struct TRLoadStatisticsEvent {
+	const char *name = nullptr;
+	uint64_t start_usec = 0;
+	uint64_t duration_usec = 0;
+	int64_t memory_delta = 0;
+	uint64_t thread_id = 0;
+};
+
+// Collects timed events for one level load. Memory deltas come from Godot's
+// own allocator bookkeeping, so they read zero in builds without memory tracking.
+class TRLoadStatistics {
+	Vector<TRLoadStatisticsEvent> events;
+	uint64_t origin_usec = 0;
+	uint64_t peak_memory_at_start = 0;
+	Dictionary scene_statistics;
+	Mutex mutex;
+
+public:
+	void reset() {
+		MutexLock lock(mutex);
+		events.clear();
+		scene_statistics = Dictionary();
+		origin_usec = OS::get_singleton()->get_ticks_usec();
+		peak_memory_at_start = Memory::get_mem_max_usage();
+	}
+
+	int32_t begin_event(const char *p_name, int64_t *r_memory_at_start) {
+		MutexLock lock(mutex);
+
+		TRLoadStatisticsEvent event;
+		event.name = p_name;
+		event.start_usec = OS::get_singleton()->get_ticks_usec() - origin_usec;
+		event.thread_id = Thread::get_caller_id();
+		events.push_back(event);
+
+		*r_memory_at_start = Memory::get_mem_usage();
+
+		return events.size() - 1;
+	}
+
+	void end_event(int32_t p_event, int64_t p_memory_at_start) {
+		MutexLock lock(mutex);
+		ERR_FAIL_INDEX(p_event, events.size());
+
+		TRLoadStatisticsEvent &event = events.write[p_event];
+		event.duration_usec = (OS::get_singleton()->get_ticks_usec() - origin_usec) - event.start_usec;
+		event.memory_delta = int64_t(Memory::get_mem_usage()) - p_memory_at_start;
+	}
+
+	// Node and draw call counts of the generated scene.
+	void set_scene_statistics(const Dictionary &p_scene_statistics) {
+		MutexLock lock(mutex);
+		scene_statistics = p_scene_statistics;
+	}
+
+	// Durations are inclusive, so nested phases are also counted in their parents.
+	Dictionary get_statistics() {
+		MutexLock lock(mutex);
+
+		Dictionary phases;
+		uint64_t end_usec = 0;
+		for (const TRLoadStatisticsEvent &event : events) {
+			Dictionary phase = phases.get(event.name, Dictionary());
+			phase["total_usec"] = int64_t(phase.get("total_usec", 0)) + int64_t(event.duration_usec);
+			phase["max_usec"] = MAX(int64_t(phase.get("max_usec", 0)), int64_t(event.duration_usec));
+			phase["count"] = int64_t(phase.get("count", 0)) + 1;
+			phase["memory_delta_bytes"] = int64_t(phase.get("memory_delta_bytes", 0)) + event.memory_delta;
+			phases[event.name] = phase;
+
+			end_usec = MAX(end_usec, event.start_usec + event.duration_usec);
+		}
+
+		Dictionary statistics;
+		statistics["total_usec"] = int64_t(end_usec);
+		statistics["phases"] = phases;
+		statistics["peak_memory_bytes"] = int64_t(Memory::get_mem_max_usage());
+		statistics["peak_memory_growth_bytes"] = int64_t(Memory::get_mem_max_usage() - peak_memory_at_start);
+		statistics["scene"] = scene_statistics.duplicate();
+
+		return statistics;
+	}
+
+	// Writes the events in the Chrome trace event format (chrome://tracing, Perfetto).
+	Error write_chrome_trace(const String &p_path) {
+		MutexLock lock(mutex);
+
+		Array trace_events;
+		for (const TRLoadStatisticsEvent &event : events) {
+			Dictionary trace_event;
+			trace_event["name"] = event.name;
+			trace_event["cat"] = "tr_lib";
+			trace_event["ph"] = "X";
+			trace_event["ts"] = int64_t(event.start_usec);
+			trace_event["dur"] = int64_t(event.duration_usec);
+			trace_event["pid"] = 1;
+			trace_event["tid"] = int64_t(event.thread_id);
+
+			Dictionary args;
+			args["memory_delta_bytes"] = event.memory_delta;
+			trace_event["args"] = args;
+
+			trace_events.push_back(trace_event);
+		}
+
+		Dictionary trace;
+		trace["traceEvents"] = trace_events;
+		trace["displayTimeUnit"] = "ms";
+
+		Error err;
+		Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+		ERR_FAIL_COND_V_MSG(file.is_null(), err, "Could not open trace file " + p_path);
+		file->store_string(JSON::stringify(trace));
+
+		return OK;
+	}
+};
+
+// Records the enclosing scope, or until stop() is called, as one event.
+// A null statistics object makes the timer a no-op.
+class TRScopedTimer {
+	TRLoadStatistics *statistics = nullptr;
+	int32_t event = -1;
+	int64_t memory_at_start = 0;
+
+public:
+	void stop() {
+		if (statistics && event >= 0) {
+			statistics->end_event(event, memory_at_start);
+			event = -1;
+		}
+	}
+
+	TRScopedTimer(TRLoadStatistics *p_statistics, const char *p_name) {
+		statistics = p_statistics;
+		if (statistics) {
+			event = statistics->begin_event(p_name, &memory_at_start);
+		}
+	}
+
+	~TRScopedTimer() {
+		stop();
+	}
+};
+
+#define TR_SCOPED_TIMER_JOIN_INTERNAL(p_a, p_b) p_a##p_b
+#define TR_SCOPED_TIMER_JOIN(p_a, p_b) TR_SCOPED_TIMER_JOIN_INTERNAL(p_a, p_b)
+#define TR_SCOPED_TIMER(p_statistics, p_name) TRScopedTimer TR_SCOPED_TIMER_JOIN(_tr_scoped_timer_, __LINE__)(p_statistics, p_name)
@@ -1,5 +1,8 @@
 #include "tr_misc.hpp"
 
+#include <core/templates/hash_set.h>
+#include <core/templates/local_vector.h>
+
 bool is_lara_compatible_humanoid(uint32_t p_type_info_id, TRLevelFormat p_level_format) {
 	switch (p_level_format) {
 	case TR1_PC:
@@ -99,4 +102,133 @@ const Ref<AnimationNode> get_animation_tree_root_node_for_object(uint32_t p_type
 	} else {
 		return p_state_machine;
 	}
-}
\ No newline at end of file
+}
+
+struct TRRoomInteriorBounds {
+	int32_t room = 0;
+	int32_t min_x = 0;
+	int32_t max_x = 0;
+	int32_t min_y = 0;
+	int32_t max_y = 0;
+	int32_t min_z = 0;
+	int32_t max_z = 0;
+};
+
+static uint64_t get_tr_room_pair_key(uint32_t p_a, uint32_t p_b) {
+	return p_a < p_b ? (uint64_t(p_a) << 32) | p_b : (uint64_t(p_b) << 32) | p_a;
+}
+
+Vector<int32_t> get_tr_room_layers(const Vector<TRRoom> &p_rooms) {
+	Vector<int32_t> room_layers;
+	room_layers.resize(p_rooms.size());
+	room_layers.fill(0);
+
+	// Rooms which may legitimately share space: portal neighbours, and rooms
+	// swapped with their flipmap alternative.
+	HashSet<uint64_t> connected_rooms;
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		const TRRoom &room = p_rooms[room_idx];
+		for (const TRRoomPortal &room_portal : room.portals) {
+			connected_rooms.insert(get_tr_room_pair_key(room_idx, room_portal.adjoining_room));
+		}
+		if (room.alternative_room >= 0) {
+			connected_rooms.insert(get_tr_room_pair_key(room_idx, room.alternative_room));
+		}
+	}
+
+	// The outermost ring of sectors is wall shared with the neighbouring
+	// rooms, so only the interiors are tested for overlap.
+	Vector<TRRoomInteriorBounds> room_bounds;
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		const TRRoom &room = p_rooms[room_idx];
+		if (room.sector_count_x <= 2 || room.sector_count_z <= 2) {
+			continue;
+		}
+
+		TRRoomInteriorBounds bounds;
+		bounds.room = room_idx;
+		bounds.min_x = room.info.x + 1024;
+		bounds.max_x = room.info.x + (room.sector_count_z - 1) * 1024;
+		bounds.min_y = room.info.y_top;
+		bounds.max_y = room.info.y_bottom;
+		bounds.min_z = room.info.z + 1024;
+		bounds.max_z = room.info.z + (room.sector_count_x - 1) * 1024;
+		room_bounds.push_back(bounds);
+	}
+
+	struct SortRoomBoundsByMinX {
+		bool operator()(const TRRoomInteriorBounds &p_a, const TRRoomInteriorBounds &p_b) const {
+			return p_a.min_x < p_b.min_x;
+		}
+	};
+	room_bounds.sort_custom<SortRoomBoundsByMinX>();
+
+	// Sweep along X, keeping the rooms whose X range is still open.
+	Vector<LocalVector<int32_t>> conflicts;
+	conflicts.resize(p_rooms.size());
+	LocalVector<int32_t> open_bounds;
+	for (int32_t bounds_idx = 0; bounds_idx < room_bounds.size(); bounds_idx++) {
+		const TRRoomInteriorBounds &bounds = room_bounds[bounds_idx];
+
+		for (uint32_t open_idx = 0; open_idx < open_bounds.size();) {
+			const TRRoomInteriorBounds &other = room_bounds[open_bounds[open_idx]];
+			if (other.max_x <= bounds.min_x) {
+				open_bounds.remove_at_unordered(open_idx);
+				continue;
+			}
+			open_idx++;
+
+			if (other.max_z <= bounds.min_z || bounds.max_z <= other.min_z || other.max_y <= bounds.min_y || bounds.max_y <= other.min_y) {
+				continue;
+			}
+			if (connected_rooms.has(get_tr_room_pair_key(bounds.room, other.room))) {
+				continue;
+			}
+
+			conflicts.write[bounds.room].push_back(other.room);
+			conflicts.write[other.room].push_back(bounds.room);
+		}
+
+		open_bounds.push_back(bounds_idx);
+	}
+
+	// DSatur colouring: always colour the room with the most distinctly
+	// coloured neighbours next, giving it the lowest layer they leave free.
+	LocalVector<int32_t> uncoloured;
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		if (!conflicts[room_idx].is_empty()) {
+			room_layers.write[room_idx] = -1;
+			uncoloured.push_back(room_idx);
+		}
+	}
+
+	Vector<HashSet<int32_t>> neighbour_layers;
+	neighbour_layers.resize(p_rooms.size());
+
+	while (!uncoloured.is_empty()) {
+		uint32_t best_idx = 0;
+		for (uint32_t candidate_idx = 1; candidate_idx < uncoloured.size(); candidate_idx++) {
+			int32_t candidate = uncoloured[candidate_idx];
+			int32_t best = uncoloured[best_idx];
+			if (neighbour_layers[candidate].size() > neighbour_layers[best].size() ||
+					(neighbour_layers[candidate].size() == neighbour_layers[best].size() && conflicts[candidate].size() > conflicts[best].size())) {
+				best_idx = candidate_idx;
+			}
+		}
+
+		int32_t room_idx = uncoloured[best_idx];
+		uncoloured.remove_at_unordered(best_idx);
+
+		int32_t layer = 0;
+		while (neighbour_layers[room_idx].has(layer)) {
+			layer++;
+		}
+		room_layers.write[room_idx] = layer;
+
+		for (int32_t neighbour : conflicts[room_idx]) {
+			neighbour_layers.write[neighbour].insert(layer);
+		}
+	}
+
+	return room_layers;
+}
@@ -8,17 +8,9 @@ struct DummyBoneInfo {
 	Quaternion rotation;
 };
 
-#define ROOM_LAYERS_TESTING
-
-static int32_t get_room_layer(uint32_t room_number) {
-#ifdef ROOM_LAYERS_TESTING
-	// TR1 Gym
-	if (room_number == 0 || room_number == 1 || room_number == 2 || room_number == 3 || room_number == 4 || room_number == 5 || room_number == 6 || room_number == 15 || room_number == 16 || room_number == 17 || room_number == 18) {
-		return room_number + 1;
-	}
-#endif
-	return 0;
-}
+// Stencil layer of every room. Rooms which overlap without being connected
+// by a portal are placed on different layers; everything else stays on 0.
+extern Vector<int32_t> get_tr_room_layers(const Vector<TRRoom> &p_rooms);
 
 
 extern bool is_lara_compatible_humanoid(uint32_t p_type_info_id, TRLevelFormat p_level_format);
@@ -0,0 +1,383 @@
+#include "tr_resource_cache.hpp"
+
+#include <core/crypto/hashing_context.h>
+#include <core/io/dir_access.h>
+#include <core/io/resource_loader.h>
+#include <core/io/resource_saver.h>
+#include <scene/resources/audio_stream_wav.h>
+#include <servers/audio/audio_stream.h>
+
+TRResourceCache *TRResourceCache::singleton = nullptr;
+
+String TRResourceCache::get_resource_file_path(const String &p_key) const {
+	return cache_path.path_join(p_key + ".res");
+}
+
+Ref<Resource> TRResourceCache::get_resource(const String &p_key) {
+	MutexLock lock(mutex);
+
+	if (resources.has(p_key)) {
+		hit_count++;
+		return resources[p_key];
+	}
+
+	if (!cache_path.is_empty()) {
+		String file_path = get_resource_file_path(p_key);
+		if (ResourceLoader::exists(file_path)) {
+			Ref<Resource> resource = ResourceLoader::load(file_path);
+			if (resource.is_valid()) {
+				resources.insert(p_key, resource);
+				hit_count++;
+				return resource;
+			}
+		}
+	}
+
+	return Ref<Resource>();
+}
+
+Ref<Resource> TRResourceCache::store_resource(const String &p_key, Ref<Resource> p_resource) {
+	ERR_FAIL_COND_V(p_resource.is_null(), p_resource);
+
+	MutexLock lock(mutex);
+
+	if (resources.has(p_key)) {
+		return resources[p_key];
+	}
+
+	miss_count++;
+
+	if (!cache_path.is_empty()) {
+		Error err = DirAccess::make_dir_recursive_absolute(cache_path);
+		if (err == OK || err == ERR_ALREADY_EXISTS) {
+			err = ResourceSaver::save(p_resource, get_resource_file_path(p_key), ResourceSaver::FLAG_CHANGE_PATH);
+		}
+		if (err != OK) {
+			ERR_PRINT("Could not write shared resource " + p_key + " to " + cache_path);
+		}
+	}
+
+	resources.insert(p_key, p_resource);
+
+	return p_resource;
+}
+
+void TRResourceCache::clear() {
+	MutexLock lock(mutex);
+	resources.clear();
+	hit_count = 0;
+	miss_count = 0;
+}
+
+TRResourceCache::TRResourceCache() {
+	singleton = this;
+}
+
+TRResourceCache::~TRResourceCache() {
+	if (singleton == this) {
+		singleton = nullptr;
+	}
+}
+
+String TRContentHasher::finish() {
+	HashingContext hashing_context;
+	hashing_context.start(HashingContext::HASH_SHA1);
+	hashing_context.update(stream_peer.get_data_array());
+
+	PackedByteArray result = hashing_context.finish();
+	return String::hex_encode_buffer(result.ptr(), result.size());
+}
+
+static void put_tr_vertex(TRContentHasher &p_hasher, const TRVertex &p_vertex) {
+	p_hasher.put_s16(p_vertex.x);
+	p_hasher.put_s16(p_vertex.y);
+	p_hasher.put_s16(p_vertex.z);
+}
+
+static void put_tr_transform(TRContentHasher &p_hasher, const TRTransform &p_transform) {
+	p_hasher.put_s32(p_transform.pos.x);
+	p_hasher.put_s32(p_transform.pos.y);
+	p_hasher.put_s32(p_transform.pos.z);
+	p_hasher.put_s16(p_transform.rot.x);
+	p_hasher.put_s16(p_transform.rot.y);
+	p_hasher.put_s16(p_transform.rot.z);
+}
+
+// Texture infos are hashed by what they actually sample rather than by their
+// index, page or position, since the same chart usually lands on a different
+// page and index in every level. Corners are taken relative to the chart, the
+// same way the mesh's own pages (see tr_mesh_to_shared_godot_mesh) lay it out.
+static void put_tr_texture_info_content(
+	TRContentHasher &p_hasher,
+	uint16_t p_texture_info_id,
+	uint8_t p_corner_count,
+	const Vector<TRTextureInfo> &p_texture_infos,
+	const Vector<Ref<Image>> &p_images) {
+	if (p_texture_info_id >= p_texture_infos.size()) {
+		p_hasher.put_u32(0xffffffff);
+		return;
+	}
+
+	const TRTextureInfo &texture_info = p_texture_infos[p_texture_info_id];
+	p_hasher.put_u16(texture_info.draw_type);
+
+	if (texture_info.texture_page >= p_images.size() || p_images[texture_info.texture_page].is_null()) {
+		p_hasher.put_u32(0xffffffff);
+		return;
+	}
+	Ref<Image> page = p_images[texture_info.texture_page];
+
+	Point2i chart_min = Point2i(INT32_MAX, INT32_MAX);
+	Point2i chart_max = Point2i(INT32_MIN, INT32_MIN);
+	for (int32_t i = 0; i < p_corner_count; i++) {
+		Point2i point = Point2i(texture_info.uv[i].u >> 8, texture_info.uv[i].v >> 8);
+		chart_min = chart_min.min(point);
+		chart_max = chart_max.max(point);
+	}
+	chart_max = chart_max.min(Point2i(page->get_width() - 1, page->get_height() - 1));
+
+	Rect2i chart = Rect2i(chart_min, chart_max - chart_min + Point2i(1, 1));
+	if (!Rect2i(0, 0, page->get_width(), page->get_height()).encloses(chart)) {
+		p_hasher.put_u32(0);
+		return;
+	}
+
+	p_hasher.put_u8(p_corner_count);
+	for (int32_t i = 0; i < p_corner_count; i++) {
+		p_hasher.put_u16((texture_info.uv[i].u >> 8) - chart.position.x);
+		p_hasher.put_u16((texture_info.uv[i].v >> 8) - chart.position.y);
+	}
+	p_hasher.put_u16(chart.size.width);
+	p_hasher.put_u16(chart.size.height);
+	p_hasher.put_data(page->get_region(chart)->get_data());
+}
+
+static void put_tr_color_face_content(TRContentHasher &p_hasher, uint16_t p_color_id, const Vector<TRColor3> &p_palette) {
+	p_hasher.put_u16(p_color_id);
+
+	uint32_t palette_index = p_color_id & 0xff;
+	if (palette_index < uint32_t(p_palette.size())) {
+		p_hasher.put_u8(p_palette[palette_index].r);
+		p_hasher.put_u8(p_palette[palette_index].g);
+		p_hasher.put_u8(p_palette[palette_index].b);
+	}
+}
+
+static void put_audio_stream_content(TRContentHasher &p_hasher, Ref<AudioStream> p_stream) {
+	Ref<AudioStreamRandomizer> randomizer = p_stream;
+	if (randomizer.is_valid()) {
+		p_hasher.put_u32(randomizer->get_streams_count());
+		for (int32_t i = 0; i < randomizer->get_streams_count(); i++) {
+			put_audio_stream_content(p_hasher, randomizer->get_stream(i));
+		}
+		return;
+	}
+
+	Ref<AudioStreamWAV> sample = p_stream;
+	if (sample.is_valid()) {
+		p_hasher.put_u32(sample->get_format());
+		p_hasher.put_u32(sample->get_mix_rate());
+		p_hasher.put_u8(sample->is_stereo());
+		p_hasher.put_u32(sample->get_loop_mode());
+		p_hasher.put_data(sample->get_data());
+		return;
+	}
+
+	p_hasher.put_u32(0xffffffff);
+}
+
+String get_tr_mesh_content_hash(
+	const TRMesh &p_mesh,
+	const Vector<TRTextureInfo> &p_texture_infos,
+	const Vector<Ref<Image>> &p_images,
+	const Vector<TRColor3> &p_palette) {
+	TRContentHasher hasher;
+
+	hasher.put_string("mesh");
+
+	// A texture info spans as many corners as the widest face using it in this mesh.
+	HashMap<uint16_t, uint8_t> corner_counts;
+	for (const TRFaceQuad &quad : p_mesh.texture_quads) {
+		corner_counts[quad.tex_info_id] = 4;
+	}
+	for (const TRFaceTriangle &triangle : p_mesh.texture_triangles) {
+		if (!corner_counts.has(triangle.tex_info_id)) {
+			corner_counts[triangle.tex_info_id] = 3;
+		}
+	}
+
+	hasher.put_u32(p_mesh.vertices.size());
+	for (const TRVertex &vertex : p_mesh.vertices) {
+		put_tr_vertex(hasher, vertex);
+	}
+
+	hasher.put_s16(p_mesh.normal_count);
+	hasher.put_u32(p_mesh.normals.size());
+	for (const TRVertex &normal : p_mesh.normals) {
+		put_tr_vertex(hasher, normal);
+	}
+
+	hasher.put_u32(p_mesh.colors.size());
+	for (const int16_t &color : p_mesh.colors) {
+		hasher.put_s16(color);
+	}
+
+	hasher.put_u32(p_mesh.texture_quads.size());
+	for (const TRFaceQuad &quad : p_mesh.texture_quads) {
+		for (int32_t i = 0; i < 4; i++) {
+			hasher.put_s16(quad.indices[i]);
+		}
+		put_tr_texture_info_content(hasher, quad.tex_info_id, corner_counts[quad.tex_info_id], p_texture_infos, p_images);
+	}
+
+	hasher.put_u32(p_mesh.texture_triangles.size());
+	for (const TRFaceTriangle &triangle : p_mesh.texture_triangles) {
+		for (int32_t i = 0; i < 3; i++) {
+			hasher.put_s16(triangle.indices[i]);
+		}
+		put_tr_texture_info_content(hasher, triangle.tex_info_id, corner_counts[triangle.tex_info_id], p_texture_infos, p_images);
+	}
+
+	hasher.put_u32(p_mesh.color_quads.size());
+	for (const TRFaceQuad &quad : p_mesh.color_quads) {
+		for (int32_t i = 0; i < 4; i++) {
+			hasher.put_s16(quad.indices[i]);
+		}
+		put_tr_color_face_content(hasher, quad.tex_info_id, p_palette);
+	}
+
+	hasher.put_u32(p_mesh.color_triangles.size());
+	for (const TRFaceTriangle &triangle : p_mesh.color_triangles) {
+		for (int32_t i = 0; i < 3; i++) {
+			hasher.put_s16(triangle.indices[i]);
+		}
+		put_tr_color_face_content(hasher, triangle.tex_info_id, p_palette);
+	}
+
+	return hasher.finish();
+}
+
+String get_tr_moveable_content_hash(
+	uint32_t p_type_info_id,
+	const TRMoveableInfo &p_moveable_info,
+	const TRTypes &p_types,
+	const Vector<Ref<AudioStream>> &p_samples,
+	TRLevelFormat p_level_format,
+	bool p_using_auxiliary_animation,
+	bool p_use_unique_names) {
+	TRContentHasher hasher;
+
+	hasher.put_string("moveable");
+	hasher.put_u32(p_type_info_id);
+	hasher.put_u32(p_level_format);
+	hasher.put_u8(p_using_auxiliary_animation);
+	hasher.put_u8(p_use_unique_names);
+
+	// Skeleton
+	hasher.put_s16(p_moveable_info.mesh_count);
+	for (int32_t i = 0; i < (p_moveable_info.mesh_count - 1) * 4; i++) {
+		int32_t bone_offset = p_moveable_info.bone_index + i;
+		if (bone_offset >= 0 && bone_offset < p_types.mesh_tree_buffer.size()) {
+			hasher.put_s32(p_types.mesh_tree_buffer[bone_offset]);
+		}
+	}
+
+	// Animations, with every cross-reference made relative to this moveable.
+	hasher.put_u32(p_moveable_info.animations.size());
+	for (const TRAnimation &animation : p_moveable_info.animations) {
+		hasher.put_u8(animation.frame_skip);
+		hasher.put_u8(animation.frame_size);
+		hasher.put_s16(animation.current_animation_state);
+		hasher.put_s32(animation.velocity);
+		hasher.put_s32(animation.acceleration);
+		hasher.put_s32(animation.lateral_velocity);
+		hasher.put_s32(animation.lateral_acceleration);
+		hasher.put_s16(animation.frame_base);
+		hasher.put_s16(animation.frame_end);
+		hasher.put_s16(animation.next_animation_number - p_moveable_info.animation_index);
+		hasher.put_s16(animation.next_frame_number);
+
+		hasher.put_u32(animation.frames.size());
+		for (const TRAnimFrame &frame : animation.frames) {
+			hasher.put_s16(frame.bounding_box.x_min);
+			hasher.put_s16(frame.bounding_box.x_max);
+			hasher.put_s16(frame.bounding_box.y_min);
+			hasher.put_s16(frame.bounding_box.y_max);
+			hasher.put_s16(frame.bounding_box.z_min);
+			hasher.put_s16(frame.bounding_box.z_max);
+
+			hasher.put_u32(frame.transforms.size());
+			for (const TRTransform &transform : frame.transforms) {
+				put_tr_transform(hasher, transform);
+			}
+		}
+
+		hasher.put_s16(animation.number_state_changes);
+		for (int32_t state_change_idx = 0; state_change_idx < animation.number_state_changes; state_change_idx++) {
+			int32_t state_change_offset = animation.state_change_index + state_change_idx;
+			if (state_change_offset < 0 || state_change_offset >= p_types.animation_state_changes.size()) {
+				continue;
+			}
+
+			const TRAnimationStateChange &state_change = p_types.animation_state_changes[state_change_offset];
+			hasher.put_s16(state_change.target_animation_state);
+			hasher.put_s16(state_change.number_dispatches);
+			for (int32_t dispatch_idx = 0; dispatch_idx < state_change.number_dispatches; dispatch_idx++) {
+				int32_t dispatch_offset = state_change.dispatch_index + dispatch_idx;
+				if (dispatch_offset < 0 || dispatch_offset >= p_types.animation_dispatches.size()) {
+					continue;
+				}
+
+				const TRAnimationDispatch &dispatch = p_types.animation_dispatches[dispatch_offset];
+				hasher.put_s16(dispatch.start_frame);
+				hasher.put_s16(dispatch.end_frame);
+				hasher.put_s16(dispatch.target_animation_number - p_moveable_info.animation_index);
+				hasher.put_s16(dispatch.target_frame_number);
+			}
+		}
+
+		hasher.put_s16(animation.number_commands);
+		int32_t command_offset = animation.command_index;
+		for (int32_t command_idx = 0; command_idx < animation.number_commands; command_idx++) {
+			if (command_offset < 0 || command_offset >= p_types.animation_commands.size()) {
+				break;
+			}
+
+			int16_t command = p_types.animation_commands[command_offset++].command;
+			hasher.put_s16(command);
+
+			int32_t argument_count = 0;
+			switch (command) {
+				case 1:
+					argument_count = 3;
+					break;
+				case 2:
+				case 5:
+				case 6:
+					argument_count = 2;
+					break;
+			}
+
+			for (int32_t argument_idx = 0; argument_idx < argument_count && command_offset < p_types.animation_commands.size(); argument_idx++) {
+				int16_t argument = p_types.animation_commands[command_offset++].command;
+				hasher.put_s16(argument);
+
+				// Sound effects are baked into the animation tracks, so hash the samples they resolve to.
+				if (command == 5 && argument_idx == 1) {
+					uint16_t sound_id = argument;
+					if (p_level_format != TR1_PC) {
+						sound_id = sound_id & 0x3fff;
+					}
+					if (sound_id < p_types.sound_map.size()) {
+						uint16_t remapped_sound_id = p_types.sound_map[sound_id];
+						if (remapped_sound_id < p_samples.size()) {
+							put_audio_stream_content(hasher, p_samples[remapped_sound_id]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return hasher.finish();
+}
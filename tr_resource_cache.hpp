@@ -0,0 +1,75 @@
+#pragma once
+#include "tr_level.hpp"
+#include "tr_level_data.hpp"
+
+#include <core/io/resource.h>
+#include <core/io/stream_peer.h>
+#include <core/os/mutex.h>
+#include <scene/resources/audio_stream_wav.h>
+
+// Content-addressed store for Godot resources generated from level data.
+// Resources are keyed by a SHA1 of the source data they were built from, so
+// objects shared between levels (Lara, pickups, common enemies) resolve to the
+// same resource instance and, when a cache path is set, to the same file on disk.
+// Levels may be loaded on worker threads, so lookups and stores are serialized.
+class TRResourceCache {
+	static TRResourceCache *singleton;
+
+	Mutex mutex;
+	HashMap<String, Ref<Resource>> resources;
+	String cache_path;
+
+	uint32_t hit_count = 0;
+	uint32_t miss_count = 0;
+
+	String get_resource_file_path(const String &p_key) const;
+
+public:
+	static TRResourceCache *get_singleton() { return singleton; }
+
+	void set_cache_path(const String &p_cache_path) { cache_path = p_cache_path; }
+	String get_cache_path() const { return cache_path; }
+
+	uint32_t get_hit_count() const { return hit_count; }
+	uint32_t get_miss_count() const { return miss_count; }
+
+	Ref<Resource> get_resource(const String &p_key);
+	Ref<Resource> store_resource(const String &p_key, Ref<Resource> p_resource);
+	void clear();
+
+	TRResourceCache();
+	~TRResourceCache();
+};
+
+class TRContentHasher {
+	StreamPeerBuffer stream_peer;
+
+public:
+	void put_u8(uint8_t p_value) { stream_peer.put_u8(p_value); }
+	void put_s16(int16_t p_value) { stream_peer.put_16(p_value); }
+	void put_u16(uint16_t p_value) { stream_peer.put_u16(p_value); }
+	void put_s32(int32_t p_value) { stream_peer.put_32(p_value); }
+	void put_u32(uint32_t p_value) { stream_peer.put_u32(p_value); }
+	void put_string(const String &p_value) { stream_peer.put_utf8_string(p_value); }
+	void put_data(const PackedByteArray &p_data) {
+		stream_peer.put_u32(p_data.size());
+		stream_peer.put_data(p_data.ptr(), p_data.size());
+	}
+
+	String finish();
+};
+
+extern String get_tr_mesh_content_hash(
+	const TRMesh &p_mesh,
+	const Vector<TRTextureInfo> &p_texture_infos,
+	const Vector<Ref<Image>> &p_images,
+	const Vector<TRColor3> &p_palette);
+
+extern String get_tr_moveable_content_hash(
+	uint32_t p_type_info_id,
+	const TRMoveableInfo &p_moveable_info,
+	const TRTypes &p_types,
+	const Vector<Ref<AudioStream>> &p_samples,
+	TRLevelFormat p_level_format,
+	bool p_using_auxiliary_animation,
+	bool p_use_unique_names);
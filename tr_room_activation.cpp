@@ -0,0 +1,218 @@
+#include "tr_room_activation.hpp"
+#include "tr_room_visibility.hpp"
+
+#include <core/config/engine.h>
+#include <scene/3d/camera_3d.h>
+#include <scene/main/viewport.h>
+
+void TRRoomActivation::_bind_methods() {
+	ClassDB::bind_method("set_rooms", &TRRoomActivation::set_rooms);
+	ClassDB::bind_method("get_rooms", &TRRoomActivation::get_rooms);
+
+	ClassDB::bind_method("set_room_visibility_path", &TRRoomActivation::set_room_visibility_path);
+	ClassDB::bind_method("get_room_visibility_path", &TRRoomActivation::get_room_visibility_path);
+
+	ClassDB::bind_method("set_entity_root_path", &TRRoomActivation::set_entity_root_path);
+	ClassDB::bind_method("get_entity_root_path", &TRRoomActivation::get_entity_root_path);
+
+	ClassDB::bind_method("set_enabled", &TRRoomActivation::set_enabled);
+	ClassDB::bind_method("is_enabled", &TRRoomActivation::is_enabled);
+
+	ClassDB::bind_method("set_activation_depth", &TRRoomActivation::set_activation_depth);
+	ClassDB::bind_method("get_activation_depth", &TRRoomActivation::get_activation_depth);
+
+	ClassDB::bind_method("set_deactivation_depth", &TRRoomActivation::set_deactivation_depth);
+	ClassDB::bind_method("get_deactivation_depth", &TRRoomActivation::get_deactivation_depth);
+
+	ClassDB::bind_method("refresh_entities", &TRRoomActivation::refresh_entities);
+	ClassDB::bind_method("get_statistics", &TRRoomActivation::get_statistics);
+
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "enabled"), "set_enabled", "is_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "activation_depth", PROPERTY_HINT_RANGE, "0,64,1"), "set_activation_depth", "get_activation_depth");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "deactivation_depth", PROPERTY_HINT_RANGE, "0,64,1"), "set_deactivation_depth", "get_deactivation_depth");
+	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "room_visibility_path", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "TRRoomVisibility"), "set_room_visibility_path", "get_room_visibility_path");
+	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "entity_root_path"), "set_entity_root_path", "get_entity_root_path");
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "rooms", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_rooms", "get_rooms");
+}
+
+void TRRoomActivation::_notification(int32_t p_what) {
+	switch (p_what) {
+		case NOTIFICATION_READY:
+			set_process_internal(enabled && !Engine::get_singleton()->is_editor_hint());
+			break;
+		case NOTIFICATION_INTERNAL_PROCESS:
+			_update_activation();
+			break;
+		case NOTIFICATION_EXIT_TREE:
+			_activate_all();
+			room_nodes_dirty = true;
+			entities_dirty = true;
+			break;
+	}
+}
+
+void TRRoomActivation::set_rooms(const Array &p_rooms) {
+	_activate_all();
+
+	room_paths = p_rooms;
+	rooms.clear();
+	rooms.resize(p_rooms.size());
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		rooms[room_idx].node_path = p_rooms[room_idx];
+	}
+
+	camera_room = -1;
+	room_nodes_dirty = true;
+}
+
+void TRRoomActivation::set_entity_root_path(const NodePath &p_entity_root_path) {
+	_activate_all();
+	entity_root_path = p_entity_root_path;
+	entities_dirty = true;
+}
+
+void TRRoomActivation::set_enabled(bool p_enabled) {
+	enabled = p_enabled;
+	if (is_inside_tree() && !Engine::get_singleton()->is_editor_hint()) {
+		set_process_internal(enabled);
+		if (!enabled) {
+			_activate_all();
+		}
+	}
+}
+
+void TRRoomActivation::set_activation_depth(int32_t p_activation_depth) {
+	activation_depth = MAX(p_activation_depth, 0);
+	deactivation_depth = MAX(deactivation_depth, activation_depth);
+}
+
+void TRRoomActivation::set_deactivation_depth(int32_t p_deactivation_depth) {
+	deactivation_depth = MAX(p_deactivation_depth, activation_depth);
+}
+
+void TRRoomActivation::_resolve_nodes() {
+	if (room_nodes_dirty) {
+		for (Room &room : rooms) {
+			Node *node = room.node_path.is_empty() ? nullptr : get_node_or_null(room.node_path);
+			room.node_id = node ? node->get_instance_id() : ObjectID();
+		}
+		room_nodes_dirty = false;
+	}
+
+	if (entities_dirty) {
+		entities.clear();
+		Node *entity_root = get_node_or_null(entity_root_path);
+		for (int32_t i = 0; entity_root && i < entity_root->get_child_count(); i++) {
+			Node3D *node = Object::cast_to<Node3D>(entity_root->get_child(i));
+			if (node) {
+				Entity entity;
+				entity.node_id = node->get_instance_id();
+				entities.push_back(entity);
+			}
+		}
+		entities_dirty = false;
+	}
+}
+
+void TRRoomActivation::_set_node_active(const ObjectID &p_node_id, bool p_active) {
+	Node *node = ObjectDB::get_instance<Node>(p_node_id);
+	if (node) {
+		node->set_process_mode(p_active ? PROCESS_MODE_INHERIT : PROCESS_MODE_DISABLED);
+	}
+}
+
+void TRRoomActivation::_activate_all() {
+	for (Room &room : rooms) {
+		if (!room.active) {
+			_set_node_active(room.node_id, true);
+			room.active = true;
+		}
+	}
+	for (Entity &entity : entities) {
+		if (!entity.active) {
+			_set_node_active(entity.node_id, true);
+			entity.active = true;
+		}
+	}
+}
+
+void TRRoomActivation::_update_activation() {
+	_resolve_nodes();
+
+	frame_statistics = FrameStatistics();
+
+	// Room lookups take positions in this node's space, which is the level's.
+	Camera3D *camera = get_viewport() ? get_viewport()->get_camera_3d() : nullptr;
+	TRRoomVisibility *room_visibility = Object::cast_to<TRRoomVisibility>(get_node_or_null(room_visibility_path));
+	Transform3D to_local = get_global_transform().affine_inverse();
+	camera_room = camera && room_visibility ? room_visibility->find_room_from(camera_room, to_local.xform(camera->get_global_position())) : -1;
+	frame_statistics.camera_room = camera_room;
+
+	// Outside of every room there is nothing to measure the distance from.
+	if (camera_room < 0) {
+		_activate_all();
+		frame_statistics.active_rooms = rooms.size();
+		frame_statistics.active_entities = entities.size();
+		return;
+	}
+
+	// Rooms past deactivation_depth come back as -1.
+	PackedInt32Array portal_distances = room_visibility->get_portal_distances(camera_room, deactivation_depth);
+	for (uint32_t room_idx = 0; room_idx < rooms.size(); room_idx++) {
+		Room &room = rooms[room_idx];
+		int32_t distance = room_idx < uint32_t(portal_distances.size()) ? portal_distances[room_idx] : -1;
+		bool active = room.active ? distance >= 0 : distance >= 0 && distance <= activation_depth;
+		if (active != room.active) {
+			_set_node_active(room.node_id, active);
+			room.active = active;
+		}
+
+		if (active) {
+			frame_statistics.active_rooms++;
+		} else {
+			frame_statistics.dormant_rooms++;
+		}
+	}
+
+	// Entities follow the room they are in, looked up in one batch with their
+	// previous rooms as hints. Dormant entities don't move, so their room
+	// stays valid until they wake up.
+	PackedVector3Array positions;
+	PackedInt32Array previous_rooms;
+	positions.resize(entities.size());
+	previous_rooms.resize(entities.size());
+	for (uint32_t entity_idx = 0; entity_idx < entities.size(); entity_idx++) {
+		Node3D *node = ObjectDB::get_instance<Node3D>(entities[entity_idx].node_id);
+		positions.set(entity_idx, node ? to_local.xform(node->get_global_position()) : Vector3());
+		previous_rooms.set(entity_idx, entities[entity_idx].room);
+	}
+	PackedInt32Array entity_rooms = room_visibility->find_rooms(positions, previous_rooms);
+
+	for (uint32_t entity_idx = 0; entity_idx < entities.size(); entity_idx++) {
+		Entity &entity = entities[entity_idx];
+		entity.room = entity_rooms[entity_idx];
+
+		// Entities outside every room stay awake rather than getting stuck.
+		bool active = entity.room < 0 || entity.room >= int32_t(rooms.size()) || rooms[entity.room].active;
+		if (active != entity.active) {
+			_set_node_active(entity.node_id, active);
+			entity.active = active;
+		}
+
+		if (active) {
+			frame_statistics.active_entities++;
+		} else {
+			frame_statistics.dormant_entities++;
+		}
+	}
+}
+
+Dictionary TRRoomActivation::get_statistics() const {
+	Dictionary statistics;
+	statistics["camera_room"] = frame_statistics.camera_room;
+	statistics["active_rooms"] = frame_statistics.active_rooms;
+	statistics["dormant_rooms"] = frame_statistics.dormant_rooms;
+	statistics["active_entities"] = frame_statistics.active_entities;
+	statistics["dormant_entities"] = frame_statistics.dormant_entities;
+	return statistics;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "tr_module_extension_abstraction_layer.hpp"
+
+#ifdef IS_MODULE
+#include "scene/3d/node_3d.h"
+#include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
+#else
+using namespace godot;
+#include <godot_cpp/classes/node3D.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#endif
+
+// Puts rooms far from the camera, and the entities standing in them, to sleep.
+// Rooms become active within activation_depth portals of the camera's room and
+// only go dormant again past deactivation_depth, so walking back and forth
+// through a portal doesn't toggle them every frame. Dormant nodes have their
+// processing disabled, which also stops their animation, audio and physics.
+class TRRoomActivation : public Node3D {
+	GDCLASS(TRRoomActivation, Node3D);
+
+	struct Room {
+		NodePath node_path;
+		ObjectID node_id;
+		bool active = true;
+	};
+
+	struct Entity {
+		ObjectID node_id;
+		int32_t room = -1;
+		bool active = true;
+	};
+
+	struct FrameStatistics {
+		int32_t camera_room = -1;
+		int32_t active_rooms = 0;
+		int32_t dormant_rooms = 0;
+		int32_t active_entities = 0;
+		int32_t dormant_entities = 0;
+	};
+
+	Array room_paths;
+	LocalVector<Room> rooms;
+	bool room_nodes_dirty = true;
+
+	NodePath room_visibility_path;
+	NodePath entity_root_path;
+	LocalVector<Entity> entities;
+	bool entities_dirty = true;
+
+	bool enabled = true;
+	int32_t activation_depth = 2;
+	int32_t deactivation_depth = 3;
+
+	int32_t camera_room = -1;
+	FrameStatistics frame_statistics;
+
+	void _resolve_nodes();
+	void _set_node_active(const ObjectID &p_node_id, bool p_active);
+	void _activate_all();
+	void _update_activation();
+protected:
+	static void _bind_methods();
+	void _notification(int32_t p_what);
+public:
+	void set_rooms(const Array &p_rooms);
+	Array get_rooms() const { return room_paths; }
+
+	void set_room_visibility_path(const NodePath &p_room_visibility_path) { room_visibility_path = p_room_visibility_path; }
+	NodePath get_room_visibility_path() const { return room_visibility_path; }
+
+	void set_entity_root_path(const NodePath &p_entity_root_path);
+	NodePath get_entity_root_path() const { return entity_root_path; }
+
+	void set_enabled(bool p_enabled);
+	bool is_enabled() const { return enabled; }
+
+	void set_activation_depth(int32_t p_activation_depth);
+	int32_t get_activation_depth() const { return activation_depth; }
+
+	void set_deactivation_depth(int32_t p_deactivation_depth);
+	int32_t get_deactivation_depth() const { return deactivation_depth; }
+
+	void refresh_entities() { entities_dirty = true; }
+	Dictionary get_statistics() const;
+};
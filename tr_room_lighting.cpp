@@ -0,0 +1,207 @@
+#include "tr_room_lighting.hpp"
+#include "tr_room_visibility.hpp"
+
+#include <core/config/engine.h>
+#include <scene/3d/visual_instance_3d.h>
+
+TRRoomLighting::TRRoomLighting() {
+	ambient_light_parameter = StringName("tr_ambient_light");
+	for (int32_t light_idx = 0; light_idx < TR_ROOM_LIGHT_LIST_SIZE; light_idx++) {
+		light_position_parameters[light_idx] = StringName("tr_light_position_" + itos(light_idx));
+		light_color_parameters[light_idx] = StringName("tr_light_color_" + itos(light_idx));
+	}
+}
+
+void TRRoomLighting::_bind_methods() {
+	ClassDB::bind_method("set_rooms", &TRRoomLighting::set_rooms);
+	ClassDB::bind_method("get_rooms", &TRRoomLighting::get_rooms);
+
+	ClassDB::bind_method("set_room_visibility_path", &TRRoomLighting::set_room_visibility_path);
+	ClassDB::bind_method("get_room_visibility_path", &TRRoomLighting::get_room_visibility_path);
+
+	ClassDB::bind_method("set_lit_root_path", &TRRoomLighting::set_lit_root_path);
+	ClassDB::bind_method("get_lit_root_path", &TRRoomLighting::get_lit_root_path);
+
+	ClassDB::bind_method("refresh_lit_nodes", &TRRoomLighting::refresh_lit_nodes);
+	ClassDB::bind_method("get_statistics", &TRRoomLighting::get_statistics);
+
+	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "room_visibility_path", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "TRRoomVisibility"), "set_room_visibility_path", "get_room_visibility_path");
+	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "lit_root_path"), "set_lit_root_path", "get_lit_root_path");
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "rooms", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_rooms", "get_rooms");
+}
+
+void TRRoomLighting::_notification(int32_t p_what) {
+	switch (p_what) {
+		case NOTIFICATION_READY:
+			set_process_internal(!Engine::get_singleton()->is_editor_hint());
+			break;
+		case NOTIFICATION_INTERNAL_PROCESS:
+			_update_lighting();
+			break;
+		case NOTIFICATION_EXIT_TREE:
+			lit_nodes_dirty = true;
+			break;
+	}
+}
+
+void TRRoomLighting::set_rooms(const Array &p_rooms) {
+	room_data = p_rooms;
+	rooms.clear();
+	rooms.resize(p_rooms.size());
+
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		Dictionary data = p_rooms[room_idx];
+		Room &room = rooms[room_idx];
+
+		room.ambient_light = data.get("ambient_light", Color(1.0, 1.0, 1.0));
+
+		PackedVector3Array light_positions = data.get("light_positions", PackedVector3Array());
+		PackedFloat32Array light_ranges = data.get("light_ranges", PackedFloat32Array());
+		PackedColorArray light_colors = data.get("light_colors", PackedColorArray());
+		ERR_CONTINUE_MSG(light_ranges.size() != light_positions.size() || light_colors.size() != light_positions.size(),
+			"Room " + itos(room_idx) + " has malformed lights.");
+
+		for (int32_t light_idx = 0; light_idx < light_positions.size(); light_idx++) {
+			RoomLight light;
+			light.position = light_positions[light_idx];
+			light.range = light_ranges[light_idx];
+			light.color = light_colors[light_idx];
+			room.lights.push_back(light);
+		}
+	}
+
+	for (LitNode &lit_node : lit_nodes) {
+		lit_node.lit = false;
+	}
+}
+
+void TRRoomLighting::set_lit_root_path(const NodePath &p_lit_root_path) {
+	lit_root_path = p_lit_root_path;
+	lit_nodes_dirty = true;
+}
+
+void TRRoomLighting::_collect_geometry(Node *p_node, LocalVector<ObjectID> &r_geometry_ids) {
+	if (Object::cast_to<GeometryInstance3D>(p_node)) {
+		r_geometry_ids.push_back(p_node->get_instance_id());
+	}
+
+	for (int32_t i = 0; i < p_node->get_child_count(); i++) {
+		_collect_geometry(p_node->get_child(i), r_geometry_ids);
+	}
+}
+
+void TRRoomLighting::_apply_room_lights(LitNode &r_lit_node, int32_t p_room, const Vector3 &p_position) {
+	// Outside of every room entities keep the neutral defaults of the shader.
+	Color ambient_light = Color(1.0, 1.0, 1.0);
+	const RoomLight *chosen_lights[TR_ROOM_LIGHT_LIST_SIZE] = {};
+	real_t chosen_weights[TR_ROOM_LIGHT_LIST_SIZE] = {};
+
+	if (p_room >= 0 && p_room < int32_t(rooms.size())) {
+		const Room &room = rooms[p_room];
+		ambient_light = room.ambient_light;
+
+		// Keep the strongest lights at this position, ordered by falloff
+		// times brightness.
+		for (const RoomLight &light : room.lights) {
+			if (light.range <= 0.0) {
+				continue;
+			}
+
+			real_t falloff = 1.0 - p_position.distance_to(light.position) / light.range;
+			real_t weight = falloff * light.color.get_luminance();
+			if (weight <= 0.0) {
+				continue;
+			}
+
+			for (int32_t slot = 0; slot < TR_ROOM_LIGHT_LIST_SIZE; slot++) {
+				if (chosen_lights[slot] && chosen_weights[slot] >= weight) {
+					continue;
+				}
+				for (int32_t shifted = TR_ROOM_LIGHT_LIST_SIZE - 1; shifted > slot; shifted--) {
+					chosen_lights[shifted] = chosen_lights[shifted - 1];
+					chosen_weights[shifted] = chosen_weights[shifted - 1];
+				}
+				chosen_lights[slot] = &light;
+				chosen_weights[slot] = weight;
+				break;
+			}
+		}
+	}
+
+	// Lights are chosen in level space, but the shaders light in world space.
+	Transform3D to_world = get_global_transform();
+	Vector4 light_positions[TR_ROOM_LIGHT_LIST_SIZE];
+	for (int32_t slot = 0; slot < TR_ROOM_LIGHT_LIST_SIZE; slot++) {
+		if (chosen_lights[slot]) {
+			Vector3 world_position = to_world.xform(chosen_lights[slot]->position);
+			light_positions[slot] = Vector4(world_position.x, world_position.y, world_position.z, chosen_lights[slot]->range);
+		}
+	}
+
+	for (const ObjectID &geometry_id : r_lit_node.geometry_ids) {
+		GeometryInstance3D *geometry = ObjectDB::get_instance<GeometryInstance3D>(geometry_id);
+		if (!geometry) {
+			continue;
+		}
+
+		geometry->set_instance_shader_parameter(ambient_light_parameter, ambient_light);
+		for (int32_t slot = 0; slot < TR_ROOM_LIGHT_LIST_SIZE; slot++) {
+			const RoomLight *light = chosen_lights[slot];
+			geometry->set_instance_shader_parameter(light_position_parameters[slot], light_positions[slot]);
+			geometry->set_instance_shader_parameter(light_color_parameters[slot], light ? light->color : Color(0.0, 0.0, 0.0));
+		}
+	}
+}
+
+void TRRoomLighting::_update_lighting() {
+	lit_node_updates = 0;
+
+	if (lit_nodes_dirty) {
+		lit_nodes.clear();
+		Node *lit_root = get_node_or_null(lit_root_path);
+		for (int32_t i = 0; lit_root && i < lit_root->get_child_count(); i++) {
+			Node3D *node = Object::cast_to<Node3D>(lit_root->get_child(i));
+			if (!node) {
+				continue;
+			}
+
+			LitNode lit_node;
+			lit_node.node_id = node->get_instance_id();
+			_collect_geometry(node, lit_node.geometry_ids);
+			if (!lit_node.geometry_ids.is_empty()) {
+				lit_nodes.push_back(lit_node);
+			}
+		}
+		lit_nodes_dirty = false;
+	}
+
+	TRRoomVisibility *room_visibility = Object::cast_to<TRRoomVisibility>(get_node_or_null(room_visibility_path));
+
+	// Room lights are in this node's space, which is the level's.
+	Transform3D to_local = get_global_transform().affine_inverse();
+
+	for (LitNode &lit_node : lit_nodes) {
+		Node3D *node = ObjectDB::get_instance<Node3D>(lit_node.node_id);
+		if (!node) {
+			continue;
+		}
+
+		Vector3 position = to_local.xform(node->get_global_position());
+		if (lit_node.lit && position.is_equal_approx(lit_node.last_position)) {
+			continue;
+		}
+
+		lit_node.room = room_visibility ? room_visibility->find_room_from(lit_node.room, position) : -1;
+		_apply_room_lights(lit_node, lit_node.room, position);
+		lit_node.last_position = position;
+		lit_node.lit = true;
+		lit_node_updates++;
+	}
+}
+
+Dictionary TRRoomLighting::get_statistics() const {
+	Dictionary statistics;
+	statistics["lit_nodes"] = int32_t(lit_nodes.size());
+	statistics["lit_node_updates"] = lit_node_updates;
+	return statistics;
+}
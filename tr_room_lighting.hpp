@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tr_module_extension_abstraction_layer.hpp"
+
+#ifdef IS_MODULE
+#include "scene/3d/node_3d.h"
+#include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
+#else
+using namespace godot;
+#include <godot_cpp/classes/node3D.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#endif
+
+// Number of room lights the light list entity shaders take per instance.
+const int32_t TR_ROOM_LIGHT_LIST_SIZE = 4;
+
+// Lights entities the way the original engines did: from the ambient level and
+// the few strongest lights of the room they stand in, rather than with
+// real-time lights. Every frame the entities which moved are placed in a room
+// and the chosen lights are written to the instance uniforms of their meshes.
+class TRRoomLighting : public Node3D {
+	GDCLASS(TRRoomLighting, Node3D);
+
+	struct RoomLight {
+		Vector3 position;
+		real_t range = 0.0;
+		Color color;
+	};
+
+	struct Room {
+		Color ambient_light = Color(1.0, 1.0, 1.0);
+		LocalVector<RoomLight> lights;
+	};
+
+	struct LitNode {
+		ObjectID node_id;
+		LocalVector<ObjectID> geometry_ids;
+		Vector3 last_position;
+		int32_t room = -1;
+		bool lit = false;
+	};
+
+	Array room_data;
+	LocalVector<Room> rooms;
+
+	NodePath room_visibility_path;
+	NodePath lit_root_path;
+
+	LocalVector<LitNode> lit_nodes;
+	bool lit_nodes_dirty = true;
+	int32_t lit_node_updates = 0;
+
+	StringName ambient_light_parameter;
+	StringName light_position_parameters[TR_ROOM_LIGHT_LIST_SIZE];
+	StringName light_color_parameters[TR_ROOM_LIGHT_LIST_SIZE];
+
+	void _collect_geometry(Node *p_node, LocalVector<ObjectID> &r_geometry_ids);
+	void _apply_room_lights(LitNode &r_lit_node, int32_t p_room, const Vector3 &p_position);
+	void _update_lighting();
+protected:
+	static void _bind_methods();
+	void _notification(int32_t p_what);
+public:
+	TRRoomLighting();
+
+	void set_rooms(const Array &p_rooms);
+	Array get_rooms() const { return room_data; }
+
+	void set_room_visibility_path(const NodePath &p_room_visibility_path) { room_visibility_path = p_room_visibility_path; }
+	NodePath get_room_visibility_path() const { return room_visibility_path; }
+
+	void set_lit_root_path(const NodePath &p_lit_root_path);
+	NodePath get_lit_root_path() const { return lit_root_path; }
+
+	void refresh_lit_nodes() { lit_nodes_dirty = true; }
+	Dictionary get_statistics() const;
+};
@@ -0,0 +1,485 @@
+#include "tr_room_visibility.hpp"
+
+#include <core/config/engine.h>
+#include <scene/3d/camera_3d.h>
+#include <scene/main/viewport.h>
+
+// Upper bound on room visits per frame, as a multiple of the room count. A
+// room reachable through several portal chains is walked once per chain.
+const int32_t TR_ROOM_VISIBILITY_VISIT_BUDGET = 8;
+
+// How far outside a sector's floor and ceiling the camera may be while still
+// counting as inside it, as a fraction of the sector size. Covers sloped
+// floors and ceilings, which the grid stores as flat heights.
+const real_t TR_ROOM_VISIBILITY_HEIGHT_TOLERANCE = 0.5;
+
+void TRRoomVisibility::_bind_methods() {
+	ClassDB::bind_method("set_rooms", &TRRoomVisibility::set_rooms);
+	ClassDB::bind_method("get_rooms", &TRRoomVisibility::get_rooms);
+
+	ClassDB::bind_method("set_enabled", &TRRoomVisibility::set_enabled);
+	ClassDB::bind_method("is_enabled", &TRRoomVisibility::is_enabled);
+
+	ClassDB::bind_method("set_max_portal_depth", &TRRoomVisibility::set_max_portal_depth);
+	ClassDB::bind_method("get_max_portal_depth", &TRRoomVisibility::get_max_portal_depth);
+
+	ClassDB::bind_method("find_room", &TRRoomVisibility::find_room);
+	ClassDB::bind_method("find_room_from", &TRRoomVisibility::find_room_from);
+	ClassDB::bind_method("find_rooms", &TRRoomVisibility::find_rooms);
+	ClassDB::bind_method("get_portal_distances", &TRRoomVisibility::get_portal_distances);
+	ClassDB::bind_method("get_current_room", &TRRoomVisibility::get_current_room);
+	ClassDB::bind_method("get_statistics", &TRRoomVisibility::get_statistics);
+
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "enabled"), "set_enabled", "is_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_portal_depth", PROPERTY_HINT_RANGE, "0,64,1"), "set_max_portal_depth", "get_max_portal_depth");
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "rooms", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_rooms", "get_rooms");
+}
+
+void TRRoomVisibility::_notification(int32_t p_what) {
+	switch (p_what) {
+		case NOTIFICATION_READY:
+			set_process_internal(enabled && !Engine::get_singleton()->is_editor_hint());
+			break;
+		case NOTIFICATION_INTERNAL_PROCESS:
+			_update_visibility();
+			break;
+		case NOTIFICATION_EXIT_TREE:
+			_apply_room_visibility(true);
+			room_nodes_dirty = true;
+			break;
+	}
+}
+
+void TRRoomVisibility::set_rooms(const Array &p_rooms) {
+	room_data = p_rooms;
+	rooms.clear();
+	rooms.resize(p_rooms.size());
+
+	for (int32_t room_idx = 0; room_idx < p_rooms.size(); room_idx++) {
+		Dictionary data = p_rooms[room_idx];
+		Room &room = rooms[room_idx];
+
+		room.node_path = data.get("node", NodePath());
+		room.sector_origin = data.get("sector_origin", Vector2());
+		room.sector_size = data.get("sector_size", 0.0);
+		room.sector_columns = data.get("sector_columns", 0);
+		room.sector_rows = data.get("sector_rows", 0);
+		room.sector_floors = data.get("sector_floors", PackedFloat32Array());
+		room.sector_ceilings = data.get("sector_ceilings", PackedFloat32Array());
+
+		int32_t sector_count = room.sector_columns * room.sector_rows;
+		if (room.sector_floors.size() != sector_count || room.sector_ceilings.size() != sector_count) {
+			ERR_PRINT("Room " + itos(room_idx) + " has a malformed sector grid.");
+			room.sector_columns = 0;
+			room.sector_rows = 0;
+		}
+
+		PackedInt32Array portal_rooms = data.get("portal_rooms", PackedInt32Array());
+		PackedVector3Array portal_normals = data.get("portal_normals", PackedVector3Array());
+		PackedVector3Array portal_vertices = data.get("portal_vertices", PackedVector3Array());
+		ERR_CONTINUE_MSG(portal_normals.size() != portal_rooms.size() || portal_vertices.size() != portal_rooms.size() * 4,
+			"Room " + itos(room_idx) + " has malformed portals.");
+
+		for (int32_t portal_idx = 0; portal_idx < portal_rooms.size(); portal_idx++) {
+			if (portal_rooms[portal_idx] < 0 || portal_rooms[portal_idx] >= p_rooms.size()) {
+				continue;
+			}
+
+			Portal portal;
+			portal.adjoining_room = portal_rooms[portal_idx];
+			portal.normal = portal_normals[portal_idx];
+			for (int32_t vertex_idx = 0; vertex_idx < 4; vertex_idx++) {
+				portal.vertices[vertex_idx] = portal_vertices[portal_idx * 4 + vertex_idx];
+			}
+			room.portals.push_back(portal);
+		}
+	}
+
+	room_reached.resize(rooms.size());
+	room_on_path.resize(rooms.size());
+	current_room = -1;
+	room_nodes_dirty = true;
+
+	_build_room_index();
+}
+
+void TRRoomVisibility::_build_room_index() {
+	room_index_columns = 0;
+	room_index_rows = 0;
+	room_index_sector_size = 0.0;
+	room_index_starts.clear();
+	room_index_entries.clear();
+
+	Vector2i min_sector;
+	Vector2i max_sector;
+	for (const Room &room : rooms) {
+		if (room.sector_size <= 0.0 || room.sector_columns <= 0 || room.sector_rows <= 0) {
+			continue;
+		}
+
+		Vector2i room_sector = Vector2i(int32_t(Math::round(room.sector_origin.x / room.sector_size)), int32_t(Math::round(room.sector_origin.y / room.sector_size)));
+		if (room_index_sector_size == 0.0) {
+			room_index_sector_size = room.sector_size;
+			min_sector = room_sector;
+			max_sector = room_sector + Vector2i(room.sector_columns, room.sector_rows);
+			continue;
+		}
+		ERR_CONTINUE_MSG(!Math::is_equal_approx(room.sector_size, room_index_sector_size), "Rooms with different sector sizes can't share the room index.");
+		min_sector = Vector2i(MIN(min_sector.x, room_sector.x), MIN(min_sector.y, room_sector.y));
+		max_sector = Vector2i(MAX(max_sector.x, room_sector.x + room.sector_columns), MAX(max_sector.y, room_sector.y + room.sector_rows));
+	}
+
+	if (room_index_sector_size == 0.0) {
+		return;
+	}
+
+	room_index_origin = min_sector;
+	room_index_columns = max_sector.x - min_sector.x;
+	room_index_rows = max_sector.y - min_sector.y;
+	room_index_starts.resize(room_index_columns * room_index_rows + 1);
+	for (int32_t &start : room_index_starts) {
+		start = 0;
+	}
+
+	// Counted first and filled second, so every cell's entries are contiguous.
+	for (int32_t pass = 0; pass < 2; pass++) {
+		LocalVector<int32_t> cursors;
+		if (pass == 1) {
+			for (uint32_t cell_idx = 1; cell_idx < room_index_starts.size(); cell_idx++) {
+				room_index_starts[cell_idx] += room_index_starts[cell_idx - 1];
+			}
+			room_index_entries.resize(room_index_starts[room_index_starts.size() - 1]);
+			cursors = room_index_starts;
+		}
+
+		for (uint32_t room_idx = 0; room_idx < rooms.size(); room_idx++) {
+			const Room &room = rooms[room_idx];
+			if (!Math::is_equal_approx(room.sector_size, room_index_sector_size)) {
+				continue;
+			}
+
+			Vector2i room_sector = Vector2i(int32_t(Math::round(room.sector_origin.x / room.sector_size)), int32_t(Math::round(room.sector_origin.y / room.sector_size))) - room_index_origin;
+			for (int32_t column = 0; column < room.sector_columns; column++) {
+				for (int32_t row = 0; row < room.sector_rows; row++) {
+					int32_t sector = column * room.sector_rows + row;
+					// Wall sectors have no space between floor and ceiling.
+					if (room.sector_floors[sector] >= room.sector_ceilings[sector]) {
+						continue;
+					}
+
+					int32_t cell = (room_sector.x + column) * room_index_rows + room_sector.y + row;
+					if (pass == 0) {
+						room_index_starts[cell + 1]++;
+						continue;
+					}
+
+					RoomIndexEntry &entry = room_index_entries[cursors[cell]++];
+					entry.room = room_idx;
+					entry.floor = room.sector_floors[sector];
+					entry.ceiling = room.sector_ceilings[sector];
+				}
+			}
+		}
+	}
+}
+
+void TRRoomVisibility::set_enabled(bool p_enabled) {
+	enabled = p_enabled;
+	if (is_inside_tree() && !Engine::get_singleton()->is_editor_hint()) {
+		set_process_internal(enabled);
+		if (!enabled) {
+			_apply_room_visibility(true);
+		}
+	}
+}
+
+void TRRoomVisibility::_resolve_room_nodes() {
+	for (Room &room : rooms) {
+		Node3D *node = room.node_path.is_empty() ? nullptr : Object::cast_to<Node3D>(get_node_or_null(room.node_path));
+		room.node_id = node ? node->get_instance_id() : ObjectID();
+		room.visible = node ? node->is_visible() : true;
+	}
+	room_nodes_dirty = false;
+}
+
+real_t TRRoomVisibility::_get_distance_outside_room(const Room &p_room, const Vector3 &p_position) const {
+	if (p_room.sector_size <= 0.0) {
+		return Math::INF;
+	}
+
+	int32_t column = int32_t(Math::floor((p_position.x - p_room.sector_origin.x) / p_room.sector_size));
+	int32_t row = int32_t(Math::floor((-p_position.z - p_room.sector_origin.y) / p_room.sector_size));
+	if (column < 0 || column >= p_room.sector_columns || row < 0 || row >= p_room.sector_rows) {
+		return Math::INF;
+	}
+
+	int32_t sector = column * p_room.sector_rows + row;
+	real_t floor = p_room.sector_floors[sector];
+	real_t ceiling = p_room.sector_ceilings[sector];
+
+	// Wall sectors have no space between floor and ceiling.
+	if (floor >= ceiling) {
+		return Math::INF;
+	}
+
+	if (p_position.y < floor) {
+		return floor - p_position.y;
+	}
+	if (p_position.y > ceiling) {
+		return p_position.y - ceiling;
+	}
+	return 0.0;
+}
+
+int32_t TRRoomVisibility::_find_room_in_index(const Vector3 &p_position) const {
+	if (room_index_sector_size <= 0.0) {
+		return -1;
+	}
+
+	int32_t column = int32_t(Math::floor(p_position.x / room_index_sector_size)) - room_index_origin.x;
+	int32_t row = int32_t(Math::floor(-p_position.z / room_index_sector_size)) - room_index_origin.y;
+	if (column < 0 || column >= room_index_columns || row < 0 || row >= room_index_rows) {
+		return -1;
+	}
+
+	int32_t cell = column * room_index_rows + row;
+	int32_t closest_room = -1;
+	real_t closest_distance = room_index_sector_size * TR_ROOM_VISIBILITY_HEIGHT_TOLERANCE;
+	for (int32_t entry_idx = room_index_starts[cell]; entry_idx < room_index_starts[cell + 1]; entry_idx++) {
+		const RoomIndexEntry &entry = room_index_entries[entry_idx];
+		real_t distance = MAX(entry.floor - p_position.y, p_position.y - entry.ceiling);
+		if (distance <= 0.0) {
+			return entry.room;
+		}
+		if (distance <= closest_distance) {
+			closest_room = entry.room;
+			closest_distance = distance;
+		}
+	}
+
+	return closest_room;
+}
+
+int32_t TRRoomVisibility::find_room(const Vector3 &p_position) const {
+	// The camera usually stays in the same room between frames.
+	return find_room_from(current_room, p_position);
+}
+
+int32_t TRRoomVisibility::find_room_from(int32_t p_previous_room, const Vector3 &p_position) const {
+	if (p_previous_room >= 0 && p_previous_room < int32_t(rooms.size())) {
+		if (_get_distance_outside_room(rooms[p_previous_room], p_position) == 0.0) {
+			return p_previous_room;
+		}
+		// Anything moving at a sane speed leaves a room through one of its portals.
+		for (const Portal &portal : rooms[p_previous_room].portals) {
+			if (_get_distance_outside_room(rooms[portal.adjoining_room], p_position) == 0.0) {
+				return portal.adjoining_room;
+			}
+		}
+	}
+
+	return _find_room_in_index(p_position);
+}
+
+PackedInt32Array TRRoomVisibility::find_rooms(const PackedVector3Array &p_positions, const PackedInt32Array &p_previous_rooms) const {
+	PackedInt32Array found_rooms;
+	found_rooms.resize(p_positions.size());
+
+	int32_t *found_rooms_ptr = found_rooms.ptrw();
+	const Vector3 *positions_ptr = p_positions.ptr();
+	const int32_t *previous_rooms_ptr = p_previous_rooms.ptr();
+	for (int32_t position_idx = 0; position_idx < p_positions.size(); position_idx++) {
+		int32_t previous_room = position_idx < p_previous_rooms.size() ? previous_rooms_ptr[position_idx] : -1;
+		found_rooms_ptr[position_idx] = find_room_from(previous_room, positions_ptr[position_idx]);
+	}
+
+	return found_rooms;
+}
+
+// Number of portals between p_room and every other room, or -1 for rooms more
+// than p_max_depth portals away. Ignores the view, unlike the culling walk.
+PackedInt32Array TRRoomVisibility::get_portal_distances(int32_t p_room, int32_t p_max_depth) const {
+	PackedInt32Array distances;
+	distances.resize(rooms.size());
+	distances.fill(-1);
+	if (p_room < 0 || p_room >= int32_t(rooms.size())) {
+		return distances;
+	}
+
+	int32_t *distances_ptr = distances.ptrw();
+	LocalVector<int32_t> queue;
+	queue.push_back(p_room);
+	distances_ptr[p_room] = 0;
+	for (uint32_t queue_idx = 0; queue_idx < queue.size(); queue_idx++) {
+		int32_t room = queue[queue_idx];
+		if (distances_ptr[room] >= p_max_depth) {
+			continue;
+		}
+		for (const Portal &portal : rooms[room].portals) {
+			if (distances_ptr[portal.adjoining_room] < 0) {
+				distances_ptr[portal.adjoining_room] = distances_ptr[room] + 1;
+				queue.push_back(portal.adjoining_room);
+			}
+		}
+	}
+
+	return distances;
+}
+
+static void clip_portal_polygon(LocalVector<Vector3> &r_polygon, const Plane &p_plane) {
+	if (r_polygon.is_empty()) {
+		return;
+	}
+
+	LocalVector<Vector3> clipped;
+	for (uint32_t vertex_idx = 0; vertex_idx < r_polygon.size(); vertex_idx++) {
+		const Vector3 &current = r_polygon[vertex_idx];
+		const Vector3 &next = r_polygon[(vertex_idx + 1) % r_polygon.size()];
+		real_t current_distance = p_plane.distance_to(current);
+		real_t next_distance = p_plane.distance_to(next);
+
+		if (current_distance <= 0.0) {
+			clipped.push_back(current);
+		}
+		if ((current_distance <= 0.0) != (next_distance <= 0.0)) {
+			clipped.push_back(current.lerp(next, current_distance / (current_distance - next_distance)));
+		}
+	}
+
+	r_polygon = clipped;
+}
+
+void TRRoomVisibility::_visit_room(int32_t p_room, const Vector3 &p_eye, const LocalVector<Plane> &p_planes, int32_t p_depth) {
+	frame_statistics.rooms_visited++;
+	room_reached[p_room] = true;
+
+	if (p_depth >= max_portal_depth || frame_statistics.rooms_visited >= int32_t(rooms.size()) * TR_ROOM_VISIBILITY_VISIT_BUDGET) {
+		return;
+	}
+
+	room_on_path[p_room] = true;
+
+	for (const Portal &portal : rooms[p_room].portals) {
+		if (room_on_path[portal.adjoining_room]) {
+			continue;
+		}
+		frame_statistics.portals_tested++;
+
+		// Portal normals face into the room they belong to.
+		real_t eye_distance = portal.normal.dot(p_eye - portal.vertices[0]);
+		if (eye_distance < 0.0) {
+			continue;
+		}
+
+		LocalVector<Vector3> polygon;
+		for (const Vector3 &vertex : portal.vertices) {
+			polygon.push_back(vertex);
+		}
+		for (const Plane &plane : p_planes) {
+			clip_portal_polygon(polygon, plane);
+		}
+		if (polygon.size() < 3) {
+			continue;
+		}
+		frame_statistics.portals_passed++;
+
+		// Standing in the portal itself leaves no usable edge planes, so the
+		// current frustum carries over unchanged.
+		if (eye_distance <= CMP_EPSILON) {
+			_visit_room(portal.adjoining_room, p_eye, p_planes, p_depth + 1);
+			continue;
+		}
+
+		Vector3 centroid;
+		for (const Vector3 &vertex : polygon) {
+			centroid += vertex;
+		}
+		centroid /= real_t(polygon.size());
+
+		LocalVector<Plane> portal_planes;
+		for (uint32_t vertex_idx = 0; vertex_idx < polygon.size(); vertex_idx++) {
+			Plane plane(p_eye, polygon[vertex_idx], polygon[(vertex_idx + 1) % polygon.size()]);
+			if (plane.normal.is_zero_approx()) {
+				continue;
+			}
+			if (plane.distance_to(centroid) > 0.0) {
+				plane = -plane;
+			}
+			portal_planes.push_back(plane);
+		}
+
+		_visit_room(portal.adjoining_room, p_eye, portal_planes, p_depth + 1);
+	}
+
+	room_on_path[p_room] = false;
+}
+
+void TRRoomVisibility::_apply_room_visibility(bool p_show_all) {
+	frame_statistics.rooms_visible = 0;
+	frame_statistics.rooms_culled = 0;
+
+	for (uint32_t room_idx = 0; room_idx < rooms.size(); room_idx++) {
+		Room &room = rooms[room_idx];
+		bool visible = p_show_all || room_reached[room_idx];
+		if (visible) {
+			frame_statistics.rooms_visible++;
+		} else {
+			frame_statistics.rooms_culled++;
+		}
+
+		if (room.visible == visible) {
+			continue;
+		}
+
+		Node3D *node = ObjectDB::get_instance<Node3D>(room.node_id);
+		if (node) {
+			node->set_visible(visible);
+		}
+		room.visible = visible;
+	}
+}
+
+void TRRoomVisibility::_update_visibility() {
+	if (room_nodes_dirty) {
+		_resolve_room_nodes();
+	}
+
+	frame_statistics = FrameStatistics();
+
+	// Portals and sector grids are in this node's space, which is the level's.
+	Camera3D *camera = get_viewport() ? get_viewport()->get_camera_3d() : nullptr;
+	Transform3D to_local = get_global_transform().affine_inverse();
+	Vector3 eye = camera ? to_local.xform(camera->get_global_position()) : Vector3();
+	current_room = camera ? find_room(eye) : -1;
+	frame_statistics.camera_room = current_room;
+
+	// Outside of every room there is no portal to look through.
+	if (current_room < 0) {
+		_apply_room_visibility(true);
+		return;
+	}
+
+	for (uint32_t room_idx = 0; room_idx < rooms.size(); room_idx++) {
+		room_reached[room_idx] = false;
+		room_on_path[room_idx] = false;
+	}
+
+	LocalVector<Plane> frustum;
+	for (const Plane &plane : camera->get_frustum()) {
+		frustum.push_back(to_local.xform(plane));
+	}
+
+	_visit_room(current_room, eye, frustum, 0);
+	_apply_room_visibility(false);
+}
+
+Dictionary TRRoomVisibility::get_statistics() const {
+	Dictionary statistics;
+	statistics["camera_room"] = frame_statistics.camera_room;
+	statistics["rooms_visited"] = frame_statistics.rooms_visited;
+	statistics["rooms_visible"] = frame_statistics.rooms_visible;
+	statistics["rooms_culled"] = frame_statistics.rooms_culled;
+	statistics["portals_tested"] = frame_statistics.portals_tested;
+	statistics["portals_passed"] = frame_statistics.portals_passed;
+	return statistics;
+}
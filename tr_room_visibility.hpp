@@ -0,0 +1,112 @@
+#pragma once
+
+#include "tr_module_extension_abstraction_layer.hpp"
+
+#ifdef IS_MODULE
+#include "scene/3d/node_3d.h"
+#include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
+#else
+using namespace godot;
+#include <godot_cpp/classes/node3D.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#endif
+
+// Portal culling for the rooms generated from a level. Each frame the room
+// containing the active camera is looked up in the rooms' sector grids, then
+// the portal graph is walked from there, narrowing the view frustum to every
+// portal it passes through. Rooms which are never reached are hidden along
+// with everything parented to them.
+//
+// Positions are placed in rooms through a level-wide sector grid listing, for
+// every sector, the rooms covering it and their floor and ceiling there.
+// Lookups try the previous room and its neighbours first. Positions passed to
+// the lookups are in this node's space, which is the level's.
+class TRRoomVisibility : public Node3D {
+	GDCLASS(TRRoomVisibility, Node3D);
+
+	struct Portal {
+		int32_t adjoining_room = -1;
+		Vector3 normal;
+		Vector3 vertices[4];
+	};
+
+	struct Room {
+		NodePath node_path;
+		ObjectID node_id;
+		bool visible = true;
+
+		// Sector grid in Godot units. Columns run along X and rows along -Z.
+		Vector2 sector_origin;
+		real_t sector_size = 0.0;
+		int32_t sector_columns = 0;
+		int32_t sector_rows = 0;
+		PackedFloat32Array sector_floors;
+		PackedFloat32Array sector_ceilings;
+
+		LocalVector<Portal> portals;
+	};
+
+	struct RoomIndexEntry {
+		int32_t room = -1;
+		real_t floor = 0.0;
+		real_t ceiling = 0.0;
+	};
+
+	struct FrameStatistics {
+		int32_t camera_room = -1;
+		int32_t rooms_visited = 0;
+		int32_t rooms_visible = 0;
+		int32_t rooms_culled = 0;
+		int32_t portals_tested = 0;
+		int32_t portals_passed = 0;
+	};
+
+	Array room_data;
+	LocalVector<Room> rooms;
+	bool room_nodes_dirty = true;
+
+	// Level-wide sector grid; the entries of cell i are
+	// room_index_entries[room_index_starts[i]..room_index_starts[i + 1]).
+	Vector2i room_index_origin;
+	int32_t room_index_columns = 0;
+	int32_t room_index_rows = 0;
+	real_t room_index_sector_size = 0.0;
+	LocalVector<int32_t> room_index_starts;
+	LocalVector<RoomIndexEntry> room_index_entries;
+
+	bool enabled = true;
+	int32_t max_portal_depth = 16;
+
+	int32_t current_room = -1;
+	LocalVector<bool> room_reached;
+	LocalVector<bool> room_on_path;
+	FrameStatistics frame_statistics;
+
+	real_t _get_distance_outside_room(const Room &p_room, const Vector3 &p_position) const;
+	void _build_room_index();
+	int32_t _find_room_in_index(const Vector3 &p_position) const;
+	void _resolve_room_nodes();
+	void _visit_room(int32_t p_room, const Vector3 &p_eye, const LocalVector<Plane> &p_planes, int32_t p_depth);
+	void _apply_room_visibility(bool p_show_all);
+	void _update_visibility();
+protected:
+	static void _bind_methods();
+	void _notification(int32_t p_what);
+public:
+	void set_rooms(const Array &p_rooms);
+	Array get_rooms() const { return room_data; }
+
+	void set_enabled(bool p_enabled);
+	bool is_enabled() const { return enabled; }
+
+	void set_max_portal_depth(int32_t p_max_portal_depth) { max_portal_depth = MAX(p_max_portal_depth, 0); }
+	int32_t get_max_portal_depth() const { return max_portal_depth; }
+
+	int32_t find_room(const Vector3 &p_position) const;
+	int32_t find_room_from(int32_t p_previous_room, const Vector3 &p_position) const;
+	PackedInt32Array find_rooms(const PackedVector3Array &p_positions, const PackedInt32Array &p_previous_rooms) const;
+	PackedInt32Array get_portal_distances(int32_t p_room, int32_t p_max_depth) const;
+	int32_t get_current_room() const { return current_room; }
+	Dictionary get_statistics() const;
+};
@@ -0,0 +1,241 @@
+#include "tr_sound_sources.hpp"
+#include "tr_room_visibility.hpp"
+
+#include <core/config/engine.h>
+#include <scene/3d/audio_stream_player_3d.h>
+#include <scene/3d/camera_3d.h>
+#include <scene/main/viewport.h>
+
+void TRSoundSources::_bind_methods() {
+	ClassDB::bind_method("set_sources", &TRSoundSources::set_sources);
+	ClassDB::bind_method("get_sources", &TRSoundSources::get_sources);
+
+	ClassDB::bind_method("set_room_visibility_path", &TRSoundSources::set_room_visibility_path);
+	ClassDB::bind_method("get_room_visibility_path", &TRSoundSources::get_room_visibility_path);
+
+	ClassDB::bind_method("set_max_portal_depth", &TRSoundSources::set_max_portal_depth);
+	ClassDB::bind_method("get_max_portal_depth", &TRSoundSources::get_max_portal_depth);
+
+	ClassDB::bind_method("set_max_voices", &TRSoundSources::set_max_voices);
+	ClassDB::bind_method("get_max_voices", &TRSoundSources::get_max_voices);
+
+	ClassDB::bind_method("get_statistics", &TRSoundSources::get_statistics);
+
+	ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "room_visibility_path", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "TRRoomVisibility"), "set_room_visibility_path", "get_room_visibility_path");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_portal_depth", PROPERTY_HINT_RANGE, "0,64,1"), "set_max_portal_depth", "get_max_portal_depth");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_voices", PROPERTY_HINT_RANGE, "1,128,1"), "set_max_voices", "get_max_voices");
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "sources", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NO_EDITOR), "set_sources", "get_sources");
+}
+
+void TRSoundSources::_notification(int32_t p_what) {
+	switch (p_what) {
+		case NOTIFICATION_READY:
+			if (!Engine::get_singleton()->is_editor_hint()) {
+				_create_voices();
+				set_process_internal(true);
+			}
+			break;
+		case NOTIFICATION_INTERNAL_PROCESS:
+			_update_voices();
+			break;
+		case NOTIFICATION_EXIT_TREE:
+			for (uint32_t voice_idx = 0; voice_idx < voices.size(); voice_idx++) {
+				_release_voice(voice_idx);
+			}
+			break;
+	}
+}
+
+void TRSoundSources::set_sources(const Array &p_sources) {
+	for (uint32_t voice_idx = 0; voice_idx < voices.size(); voice_idx++) {
+		_release_voice(voice_idx);
+	}
+
+	source_data = p_sources;
+	sources.clear();
+
+	for (int32_t source_idx = 0; source_idx < p_sources.size(); source_idx++) {
+		Dictionary data = p_sources[source_idx];
+
+		Source source;
+		source.position = data.get("position", Vector3());
+		source.room = data.get("room", -1);
+		source.stream = data.get("stream", Ref<AudioStream>());
+		source.priority = data.get("priority", 0);
+		source.volume_db = data.get("volume_db", 0.0);
+		source.max_distance = data.get("max_distance", 0.0);
+		source.looping = data.get("looping", false);
+		ERR_CONTINUE_MSG(source.stream.is_null() || source.max_distance <= 0.0, "Sound source " + itos(source_idx) + " is malformed.");
+
+		sources.push_back(source);
+	}
+}
+
+void TRSoundSources::set_max_voices(int32_t p_max_voices) {
+	max_voices = MAX(p_max_voices, 1);
+	if (!voices.is_empty()) {
+		_free_voices();
+		_create_voices();
+	}
+}
+
+// Voices are internal children, so they are neither saved with the scene nor
+// shown in the editor.
+void TRSoundSources::_create_voices() {
+	for (int32_t voice_idx = 0; voice_idx < max_voices; voice_idx++) {
+		AudioStreamPlayer3D *player = memnew(AudioStreamPlayer3D);
+		player->set_name("Voice_" + itos(voice_idx));
+		player->set_playback_type(AudioServer::PLAYBACK_TYPE_SAMPLE);
+		add_child(player, false, INTERNAL_MODE_BACK);
+
+		Voice voice;
+		voice.player_id = player->get_instance_id();
+		voices.push_back(voice);
+	}
+}
+
+void TRSoundSources::_free_voices() {
+	for (uint32_t voice_idx = 0; voice_idx < voices.size(); voice_idx++) {
+		_release_voice(voice_idx);
+		AudioStreamPlayer3D *player = ObjectDB::get_instance<AudioStreamPlayer3D>(voices[voice_idx].player_id);
+		if (player) {
+			remove_child(player);
+			memdelete(player);
+		}
+	}
+	voices.clear();
+}
+
+void TRSoundSources::_release_voice(int32_t p_voice) {
+	Voice &voice = voices[p_voice];
+	if (voice.source < 0) {
+		return;
+	}
+
+	AudioStreamPlayer3D *player = ObjectDB::get_instance<AudioStreamPlayer3D>(voice.player_id);
+	if (player) {
+		player->stop();
+	}
+	if (voice.source < int32_t(sources.size())) {
+		sources[voice.source].voice = -1;
+	}
+	voice.source = -1;
+}
+
+void TRSoundSources::_update_voices() {
+	frame_statistics = FrameStatistics();
+
+	Camera3D *camera = get_viewport() ? get_viewport()->get_camera_3d() : nullptr;
+	TRRoomVisibility *room_visibility = Object::cast_to<TRRoomVisibility>(get_node_or_null(room_visibility_path));
+	if (!camera) {
+		for (uint32_t voice_idx = 0; voice_idx < voices.size(); voice_idx++) {
+			_release_voice(voice_idx);
+		}
+		return;
+	}
+
+	// Sources are in this node's space, which is the level's.
+	Vector3 listener_position = get_global_transform().affine_inverse().xform(camera->get_global_position());
+	listener_room = room_visibility ? room_visibility->find_room_from(listener_room, listener_position) : -1;
+	frame_statistics.listener_room = listener_room;
+
+	// Without a room for the listener (or rooms for the sources) portal
+	// culling is skipped and only range applies.
+	PackedInt32Array portal_distances;
+	if (room_visibility && listener_room >= 0) {
+		portal_distances = room_visibility->get_portal_distances(listener_room, max_portal_depth);
+	}
+
+	struct Candidate {
+		int32_t source = -1;
+		real_t weight = 0.0;
+	};
+
+	struct CandidateComparator {
+		bool operator()(const Candidate &p_a, const Candidate &p_b) const {
+			return p_a.weight > p_b.weight;
+		}
+	};
+
+	LocalVector<Candidate> candidates;
+	for (uint32_t source_idx = 0; source_idx < sources.size(); source_idx++) {
+		const Source &source = sources[source_idx];
+		if (!portal_distances.is_empty() && source.room >= 0 && source.room < portal_distances.size() && portal_distances[source.room] < 0) {
+			frame_statistics.sources_culled_by_portals++;
+			continue;
+		}
+
+		real_t distance = listener_position.distance_to(source.position);
+		if (distance >= source.max_distance) {
+			frame_statistics.sources_out_of_range++;
+			continue;
+		}
+
+		frame_statistics.sources_in_reach++;
+		Candidate candidate;
+		candidate.source = source_idx;
+		candidate.weight = real_t(source.priority) * (1.0 - distance / source.max_distance);
+		candidates.push_back(candidate);
+	}
+
+	if (candidates.size() > voices.size()) {
+		candidates.sort_custom<CandidateComparator>();
+		candidates.resize(voices.size());
+	}
+
+	// Sources which keep playing keep their voice, so loops aren't restarted.
+	LocalVector<bool> chosen;
+	chosen.resize(sources.size());
+	for (bool &is_chosen : chosen) {
+		is_chosen = false;
+	}
+	for (const Candidate &candidate : candidates) {
+		chosen[candidate.source] = true;
+	}
+	for (uint32_t voice_idx = 0; voice_idx < voices.size(); voice_idx++) {
+		if (voices[voice_idx].source >= 0 && !chosen[voices[voice_idx].source]) {
+			_release_voice(voice_idx);
+		}
+	}
+
+	uint32_t free_voice_idx = 0;
+	for (const Candidate &candidate : candidates) {
+		Source &source = sources[candidate.source];
+		if (source.voice < 0) {
+			while (voices[free_voice_idx].source >= 0) {
+				free_voice_idx++;
+			}
+
+			AudioStreamPlayer3D *player = ObjectDB::get_instance<AudioStreamPlayer3D>(voices[free_voice_idx].player_id);
+			if (!player) {
+				continue;
+			}
+			player->set_stream(source.stream);
+			player->set_position(source.position);
+			player->set_volume_db(source.volume_db);
+			player->set_max_distance(source.max_distance);
+			player->play();
+
+			voices[free_voice_idx].source = candidate.source;
+			source.voice = free_voice_idx;
+		} else if (!source.looping) {
+			// One-shot ambience repeats for as long as the source holds a voice.
+			AudioStreamPlayer3D *player = ObjectDB::get_instance<AudioStreamPlayer3D>(voices[source.voice].player_id);
+			if (player && !player->is_playing()) {
+				player->play();
+			}
+		}
+		frame_statistics.voices_playing++;
+	}
+}
+
+Dictionary TRSoundSources::get_statistics() const {
+	Dictionary statistics;
+	statistics["sources"] = int32_t(sources.size());
+	statistics["listener_room"] = frame_statistics.listener_room;
+	statistics["sources_in_reach"] = frame_statistics.sources_in_reach;
+	statistics["sources_culled_by_portals"] = frame_statistics.sources_culled_by_portals;
+	statistics["sources_out_of_range"] = frame_statistics.sources_out_of_range;
+	statistics["voices_playing"] = frame_statistics.voices_playing;
+	return statistics;
+}
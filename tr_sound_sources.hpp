@@ -0,0 +1,81 @@
+#pragma once
+
+#include "tr_module_extension_abstraction_layer.hpp"
+
+#ifdef IS_MODULE
+#include "scene/3d/node_3d.h"
+#include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
+#include "servers/audio/audio_stream.h"
+#else
+using namespace godot;
+#include <godot_cpp/classes/node3D.hpp>
+#include <godot_cpp/classes/audio_stream.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#endif
+
+// Plays the level's ambient sound sources through a small pool of voices.
+// Sources whose room is more than max_portal_depth portals from the
+// listener's room, or which are out of their own range, are culled. The rest
+// compete for max_voices by volume, weighted by their distance to the
+// listener, so sources keep their voice while they stay among the loudest.
+class TRSoundSources : public Node3D {
+	GDCLASS(TRSoundSources, Node3D);
+
+	struct Source {
+		Vector3 position;
+		int32_t room = -1;
+		Ref<AudioStream> stream;
+		int32_t priority = 0;
+		real_t volume_db = 0.0;
+		real_t max_distance = 0.0;
+		bool looping = false;
+		int32_t voice = -1;
+	};
+
+	struct Voice {
+		ObjectID player_id;
+		int32_t source = -1;
+	};
+
+	struct FrameStatistics {
+		int32_t listener_room = -1;
+		int32_t sources_in_reach = 0;
+		int32_t sources_culled_by_portals = 0;
+		int32_t sources_out_of_range = 0;
+		int32_t voices_playing = 0;
+	};
+
+	Array source_data;
+	LocalVector<Source> sources;
+	LocalVector<Voice> voices;
+
+	NodePath room_visibility_path;
+	int32_t max_portal_depth = 3;
+	int32_t max_voices = 16;
+
+	int32_t listener_room = -1;
+	FrameStatistics frame_statistics;
+
+	void _create_voices();
+	void _free_voices();
+	void _release_voice(int32_t p_voice);
+	void _update_voices();
+protected:
+	static void _bind_methods();
+	void _notification(int32_t p_what);
+public:
+	void set_sources(const Array &p_sources);
+	Array get_sources() const { return source_data; }
+
+	void set_room_visibility_path(const NodePath &p_room_visibility_path) { room_visibility_path = p_room_visibility_path; }
+	NodePath get_room_visibility_path() const { return room_visibility_path; }
+
+	void set_max_portal_depth(int32_t p_max_portal_depth) { max_portal_depth = MAX(p_max_portal_depth, 0); }
+	int32_t get_max_portal_depth() const { return max_portal_depth; }
+
+	void set_max_voices(int32_t p_max_voices);
+	int32_t get_max_voices() const { return max_voices; }
+
+	Dictionary get_statistics() const;
+};